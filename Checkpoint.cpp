@@ -0,0 +1,241 @@
+#include "Checkpoint.h"
+#include "Sim_object.h"
+#include "Utility.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using std::string;
+using std::map;
+using std::shared_ptr;
+
+const char checkpoint_magic_c[] = {'P', '5', 'C', 'P'};
+// added to the name of the file to name the file a checkpoint is written to first
+const char* const checkpoint_temporary_suffix_c = ".tmp";
+const unsigned checkpoint_version_c = 1;
+// sizes in bytes of the values in a checkpoint
+const int int_size_c = 4;
+const int double_size_c = 8;
+const int offset_size_c = 8;
+const int bits_per_byte_c = 8;
+const std::size_t header_size_c = sizeof(checkpoint_magic_c) + 2 * int_size_c;
+const std::size_t table_entry_size_c = int_size_c + 2 * offset_size_c;
+
+static void invalid_checkpoint()
+{
+    throw Error("Invalid checkpoint file!");
+}
+
+void Checkpoint_writer::put_int(int value)
+{
+    put_bits(static_cast<unsigned>(value), int_size_c);
+}
+
+void Checkpoint_writer::put_unsigned(unsigned value)
+{
+    put_bits(value, int_size_c);
+}
+
+void Checkpoint_writer::put_size(std::size_t value)
+{
+    put_bits(value, offset_size_c);
+}
+
+void Checkpoint_writer::put_double(double value)
+{
+    unsigned long long bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_bits(bits, double_size_c);
+}
+
+void Checkpoint_writer::put_point(Point p)
+{
+    put_double(p.x);
+    put_double(p.y);
+}
+
+void Checkpoint_writer::put_string(const string& s)
+{
+    put_unsigned(s.size());
+    bytes += s;
+}
+
+void Checkpoint_writer::put_object(const Sim_object* object_ptr)
+{
+    put_string(object_ptr ? object_ptr->get_name() : string());
+}
+
+// the bytes are appended at once, since a History saves the whole Model at each update
+void Checkpoint_writer::put_bits(unsigned long long bits, int n_bytes)
+{
+    char buffer[offset_size_c];
+    for (int i = 0; i < n_bytes; i++)
+        buffer[i] = char(bits >> (i * bits_per_byte_c));
+    bytes.append(buffer, n_bytes);
+}
+
+int Checkpoint_reader::get_int()
+{
+    return int(static_cast<unsigned>(get_bits(int_size_c)));
+}
+
+unsigned Checkpoint_reader::get_unsigned()
+{
+    return static_cast<unsigned>(get_bits(int_size_c));
+}
+
+std::size_t Checkpoint_reader::get_size()
+{
+    return std::size_t(get_bits(offset_size_c));
+}
+
+bool Checkpoint_reader::get_bool()
+{
+    return get_enum(2) != 0;
+}
+
+double Checkpoint_reader::get_double()
+{
+    unsigned long long bits = get_bits(double_size_c);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+Point Checkpoint_reader::get_point()
+{
+    double x = get_double();
+    return Point(x, get_double());
+}
+
+string Checkpoint_reader::get_string()
+{
+    unsigned length = get_unsigned();
+    return string(skip(length), length);
+}
+
+int Checkpoint_reader::get_enum(int n_values)
+{
+    unsigned value = get_unsigned();
+    if (value >= unsigned(n_values))
+        invalid_checkpoint();
+    return int(value);
+}
+
+shared_ptr<Island> Checkpoint_reader::get_island_ptr()
+{
+    string name = get_string();
+    if (name.empty())
+        return nullptr;
+    if (!islands)
+        invalid_checkpoint();
+    auto island_it = islands->find(name);
+    if (island_it == islands->end())
+        invalid_checkpoint();
+    return island_it->second;
+}
+
+shared_ptr<Ship> Checkpoint_reader::get_ship_ptr()
+{
+    string name = get_string();
+    if (name.empty())
+        return nullptr;
+    if (!ships)
+        invalid_checkpoint();
+    auto ship_it = ships->find(name);
+    if (ship_it == ships->end())
+        invalid_checkpoint();
+    return ship_it->second;
+}
+
+const char* Checkpoint_reader::skip(std::size_t n)
+{
+    if (n > size - position)
+        invalid_checkpoint();
+    const char* skipped = data + position;
+    position += n;
+    return skipped;
+}
+
+void Checkpoint_reader::check_end() const
+{
+    if (position != size)
+        invalid_checkpoint();
+}
+
+unsigned long long Checkpoint_reader::get_bits(int n_bytes)
+{
+    const char* bytes = skip(n_bytes);
+    unsigned long long bits = 0;
+    for (int i = 0; i < n_bytes; i++)
+        bits |= static_cast<unsigned long long>(static_cast<unsigned char>(bytes[i]))
+            << (i * bits_per_byte_c);
+    return bits;
+}
+
+const string& Checkpoint::get_section(Checkpoint_section_e id) const
+{
+    auto section_it = sections.find(id);
+    if (section_it == sections.end())
+        invalid_checkpoint();
+    return section_it->second;
+}
+
+// The header and table are written first, with the offsets the sections will be at.
+// The checkpoint is written to a temporary file, which is then renamed over the file.
+void Checkpoint::save(const string& filename) const
+{
+    Checkpoint_writer header;
+    header.put_unsigned(checkpoint_version_c);
+    header.put_unsigned(sections.size());
+    std::size_t offset = header_size_c + sections.size() * table_entry_size_c;
+    for (auto& section : sections) {
+        header.put_unsigned(section.first);
+        header.put_size(offset);
+        header.put_size(section.second.size());
+        offset += section.second.size();
+    }
+    string temporary_filename = filename + checkpoint_temporary_suffix_c;
+    std::ofstream file(temporary_filename, std::ios::binary | std::ios::trunc);
+    file.write(checkpoint_magic_c, sizeof(checkpoint_magic_c));
+    file.write(header.get_bytes().data(), header.get_bytes().size());
+    for (auto& section : sections)
+        file.write(section.second.data(), section.second.size());
+    file.close();
+    if (!file || std::rename(temporary_filename.c_str(), filename.c_str())) {
+        std::remove(temporary_filename.c_str());
+        throw Error("Could not write checkpoint file!");
+    }
+}
+
+void Checkpoint::load(const string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        throw Error("Could not open checkpoint file!");
+    file.seekg(0, std::ios::end);
+    std::streamoff file_size = file.tellg();
+    if (file_size < 0)
+        throw Error("Could not open checkpoint file!");
+    string contents(std::size_t(file_size), '\0');
+    file.seekg(0);
+    if (!file.read(&contents[0], contents.size()))
+        throw Error("Could not open checkpoint file!");
+    Checkpoint_reader reader(contents.data(), contents.size());
+    if (std::memcmp(reader.skip(sizeof(checkpoint_magic_c)), checkpoint_magic_c,
+                    sizeof(checkpoint_magic_c)))
+        invalid_checkpoint();
+    if (reader.get_unsigned() != checkpoint_version_c)
+        throw Error("Unsupported checkpoint version!");
+    unsigned n_sections = reader.get_unsigned();
+    map<unsigned, string> new_sections;
+    for (unsigned i = 0; i < n_sections; i++) {
+        unsigned id = reader.get_unsigned();
+        std::size_t offset = reader.get_size();
+        std::size_t section_size = reader.get_size();
+        if (offset > contents.size() || section_size > contents.size() - offset)
+            invalid_checkpoint();
+        new_sections[id].assign(contents, offset, section_size);
+    }
+    sections.swap(new_sections);
+}
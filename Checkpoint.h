@@ -0,0 +1,121 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "Geometry.h"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+
+/*
+A Checkpoint holds the complete state of a simulation - the Model's settings, every
+island and ship, and the Controller's views - as sections of binary data, so that it can
+be saved to a file and the simulation restored from it later without replaying commands.
+
+The file starts with a header, a table of the sections, and then the sections' data;
+all numbers are little-endian:
+	char magic[4]			"P5CP"
+	uint32 version			checkpoint_version_c
+	uint32 n_sections
+	n_sections entries of	uint32 id, uint64 offset from the start of the file, uint64 size
+Sections with ids that are not known are ignored, so that later versions can add them.
+
+Checkpoint_writer and Checkpoint_reader encode and decode the values in a section:
+integers as 4 bytes, sizes and doubles as their 8-byte representation, and strings as their
+4-byte length followed by their bytes. References to islands and ships are written as their
+names, the empty name for none; a reader set up with the objects being restored finds
+them by name. Any error in reading a checkpoint throws Error("Invalid checkpoint file!").
+*/
+
+class Sim_object;
+class Island;
+class Ship;
+
+enum Checkpoint_section_e {MODEL_SECTION = 1, ISLANDS_SECTION, SHIPS_SECTION, VIEWS_SECTION};
+
+class Checkpoint_writer {
+public:
+	void put_int(int value);
+	void put_unsigned(unsigned value);
+	// 8 bytes, for sizes and offsets in a file
+	void put_size(std::size_t value);
+	void put_bool(bool value)
+		{put_unsigned(value);}
+	void put_double(double value);
+	void put_point(Point p);
+	void put_string(const std::string& s);
+	// the object's name, or the empty name for none
+	void put_object(const Sim_object* object_ptr);
+
+	const std::string& get_bytes() const
+		{return bytes;}
+
+private:
+	std::string bytes;
+
+	void put_bits(unsigned long long bits, int n_bytes);
+};
+
+class Checkpoint_reader {
+public:
+	typedef std::map<std::string, std::shared_ptr<Island> > Islands_t;
+	typedef std::map<std::string, std::shared_ptr<Ship> > Ships_t;
+
+	// read the bytes, which must outlive the reader; references to objects are
+	// looked up in the containers, if they are supplied
+	Checkpoint_reader(const char* data_, std::size_t size_, const Islands_t* islands_ = nullptr,
+		const Ships_t* ships_ = nullptr) :
+		data(data_), size(size_), position(0), islands(islands_), ships(ships_) {}
+
+	int get_int();
+	unsigned get_unsigned();
+	std::size_t get_size();
+	bool get_bool();
+	double get_double();
+	Point get_point();
+	std::string get_string();
+	// an unsigned value that must be less than n_values, such as an enum
+	int get_enum(int n_values);
+	// the object with the name read, or nullptr for the empty name
+	std::shared_ptr<Island> get_island_ptr();
+	std::shared_ptr<Ship> get_ship_ptr();
+	// skip over n bytes, returning a pointer to them
+	const char* skip(std::size_t n);
+	// everything must have been read
+	void check_end() const;
+
+private:
+	const char* data;
+	std::size_t size;
+	std::size_t position;
+	const Islands_t* islands;
+	const Ships_t* ships;
+
+	unsigned long long get_bits(int n_bytes);
+};
+
+class Checkpoint {
+public:
+	void set_section(Checkpoint_section_e id, const std::string& bytes)
+		{sections[id] = bytes;}
+	// will throw Error("Invalid checkpoint file!") if there is no such section
+	const std::string& get_section(Checkpoint_section_e id) const;
+
+	// the file is replaced only once the whole checkpoint has been written, so a
+	// failed save leaves any earlier checkpoint in it whole
+	// will throw Error("Could not write checkpoint file!")
+	void save(const std::string& filename) const;
+	// replace the sections with those in the file
+	// will throw Error("Could not open checkpoint file!"),
+	// Error("Unsupported checkpoint version!"), or Error("Invalid checkpoint file!")
+	void load(const std::string& filename);
+
+	// do the checkpoints hold the same state?
+	bool is_same_as(const Checkpoint& other) const
+		{return sections == other.sections;}
+
+private:
+	std::map<unsigned, std::string> sections;
+};
+
+#endif
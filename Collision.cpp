@@ -0,0 +1,144 @@
+#include "Collision.h"
+#include <algorithm>
+#include <thread>
+#include <functional>
+#include <cmath>
+
+using std::string;
+using std::vector;
+using std::thread;
+using std::sort; using std::min; using std::max;
+
+// below this many bodies the sweep is not worth dividing among threads
+const size_t parallel_sweep_threshold_c = 10000;
+
+namespace {
+
+struct Sweep_entry {
+    double min_x, max_x, min_y, max_y;
+    const Swept_body* body;
+};
+
+bool is_stationary(const Swept_body& body)
+{
+    return body.start == body.end;
+}
+
+// A ship that ends the update exactly on an island's position has arrived there
+// (this is how a ship reaches an island it will dock at), and one that starts there
+// is leaving it, so neither is a collision.
+bool is_arrival_or_departure(const Swept_body& ship, const Swept_body& island)
+{
+    return !ship.is_island && island.is_island &&
+        (ship.end == island.start || ship.start == island.start);
+}
+
+// Find the first time in [0, 1] at which the two bodies come within contact_distance,
+// return false if they never do; bodies already that close at the start were reported
+// when they came together, so they are not reported again.
+bool first_contact(const Swept_body& b1, const Swept_body& b2, double contact_distance,
+                   double& time)
+{
+    Cartesian_vector d0 = b1.start - b2.start;
+    Cartesian_vector dv = (b1.end - b1.start) - (b2.end - b2.start);
+    double c = d0.delta_x * d0.delta_x + d0.delta_y * d0.delta_y
+        - contact_distance * contact_distance;
+    if (c <= 0.)
+        return false;
+    double a = dv.delta_x * dv.delta_x + dv.delta_y * dv.delta_y;
+    if (a == 0.)
+        return false;
+    double b = 2. * (d0.delta_x * dv.delta_x + d0.delta_y * dv.delta_y);
+    double discriminant = b * b - 4. * a * c;
+    if (discriminant < 0.)
+        return false;
+    time = (-b - sqrt(discriminant)) / (2. * a);
+    return time >= 0. && time <= 1.;
+}
+
+void narrowphase(const Swept_body& b1, const Swept_body& b2, double contact_distance,
+                 vector<Contact>& contacts)
+{
+    if ((is_stationary(b1) && is_stationary(b2)) || is_arrival_or_departure(b1, b2) || is_arrival_or_departure(b2, b1))
+        return;
+    double time;
+    if (!first_contact(b1, b2, contact_distance, time))
+        return;
+    Point p1 = b1.start + (b1.end - b1.start) * time;
+    Point p2 = b2.start + (b2.end - b2.start) * time;
+    const Swept_body& first = (*b1.name < *b2.name) ? b1 : b2;
+    const Swept_body& second = (&first == &b1) ? b2 : b1;
+    Contact contact;
+    contact.name1 = first.name;
+    contact.name2 = second.name;
+    contact.is_island1 = first.is_island;
+    contact.is_island2 = second.is_island;
+    contact.location = p1 + (p2 - p1) * 0.5;
+    contact.time = time;
+    contacts.push_back(contact);
+}
+
+// Each entry is tested against the following entries whose x extent starts before
+// its own ends; entries are sorted by min_x, so the scan can stop at the first that doesn't.
+void sweep(const vector<Sweep_entry>& entries, size_t begin, size_t end,
+           double contact_distance, vector<Contact>& contacts)
+{
+    for (size_t i = begin; i < end; i++) {
+        const Sweep_entry& entry = entries[i];
+        for (size_t j = i + 1; j < entries.size() && entries[j].min_x <= entry.max_x; j++) {
+            if (entries[j].min_y <= entry.max_y && entries[j].max_y >= entry.min_y)
+                narrowphase(*entry.body, *entries[j].body, contact_distance, contacts);
+        }
+    }
+}
+
+bool contact_order(const Contact& c1, const Contact& c2)
+{
+    if (*c1.name1 != *c2.name1)
+        return *c1.name1 < *c2.name1;
+    return *c1.name2 < *c2.name2;
+}
+
+}
+
+vector<Contact> find_contacts(const vector<Swept_body>& bodies, double contact_distance)
+{
+    // each extent is grown by half the contact distance, so bodies within the
+    // contact distance of each other have overlapping extents
+    double margin = contact_distance / 2.;
+    vector<Sweep_entry> entries;
+    entries.reserve(bodies.size());
+    for (auto& body : bodies) {
+        Sweep_entry entry;
+        entry.min_x = min(body.start.x, body.end.x) - margin;
+        entry.max_x = max(body.start.x, body.end.x) + margin;
+        entry.min_y = min(body.start.y, body.end.y) - margin;
+        entry.max_y = max(body.start.y, body.end.y) + margin;
+        entry.body = &body;
+        entries.push_back(entry);
+    }
+    sort(entries.begin(), entries.end(),
+         [](const Sweep_entry& e1, const Sweep_entry& e2){return e1.min_x < e2.min_x;});
+
+    vector<Contact> contacts;
+    size_t n_threads = thread::hardware_concurrency();
+    if (entries.size() < parallel_sweep_threshold_c || n_threads < 2)
+        sweep(entries, 0, entries.size(), contact_distance, contacts);
+    else {
+        vector<vector<Contact> > thread_contacts(n_threads);
+        vector<thread> threads;
+        size_t chunk = (entries.size() + n_threads - 1) / n_threads;
+        for (size_t t = 0; t < n_threads; t++) {
+            size_t begin = min(t * chunk, entries.size());
+            size_t end = min(begin + chunk, entries.size());
+            threads.push_back(thread(sweep, std::cref(entries), begin, end,
+                                     contact_distance, std::ref(thread_contacts[t])));
+        }
+        for (auto& worker : threads)
+            worker.join();
+        for (auto& partial : thread_contacts)
+            contacts.insert(contacts.end(), partial.begin(), partial.end());
+    }
+    sort(contacts.begin(), contacts.end(), contact_order);
+    return contacts;
+}
@@ -0,0 +1,46 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "Geometry.h"
+#include <string>
+#include <vector>
+
+/*
+This module detects contacts between objects that move during a single update.
+Each object is described by a Swept_body - its position at the start and at the end
+of the update, assuming straight-line motion at constant speed in between. Stationary
+objects such as Islands have the same start and end position.
+
+find_contacts uses a sort-and-sweep broadphase on the x extent of each swept segment,
+then an exact narrowphase that finds the first time during the update at which the two
+bodies come within the contact distance of each other (both move at the same time, so
+this is a relative-motion computation, not a simple segment-to-segment distance).
+Only pairs that come into contact are reported - not those already in contact at the
+start of the update - and pairs of stationary bodies are never reported.
+For large numbers of bodies, the sweep is divided among several threads.
+*/
+
+struct Swept_body {
+	const std::string* name;	// points to a name owned by the caller
+	Point start;
+	Point end;
+	bool is_island;
+
+	Swept_body(const std::string* name_, Point start_, Point end_, bool is_island_ = false) :
+		name(name_), start(start_), end(end_), is_island(is_island_)
+		{}
+};
+
+struct Contact {
+	const std::string* name1;	// name1 is always alphabetically before name2
+	const std::string* name2;
+	bool is_island1;
+	bool is_island2;
+	Point location;				// midpoint of the two bodies at first contact
+	double time;				// fraction of the update at which first contact occurs
+};
+
+// Return all contacts among the bodies, ordered by the names of the pair.
+std::vector<Contact> find_contacts(const std::vector<Swept_body>& bodies, double contact_distance);
+
+#endif
@@ -0,0 +1,188 @@
+#include "Contact_index.h"
+#include "Navigation.h"
+#include <algorithm>
+#include <cmath>
+
+using std::string;
+using std::vector;
+using std::lower_bound;
+using std::remove;
+using std::sort;
+using std::size_t;
+
+// the size of the grid cells the objects are kept in
+const double contact_cell_size_c = 10.;
+
+// compares Contacts by bearing
+static bool bearing_less(const Contact_index::Contact& contact, double bearing);
+static bool contact_less(const Contact_index::Contact& c1, const Contact_index::Contact& c2);
+// append to contacts those of sorted in [first, last) within the range band
+static void append_in_range(vector<Contact_index::Contact>::const_iterator first,
+                            vector<Contact_index::Contact>::const_iterator last,
+                            double min_range, double max_range,
+                            vector<Contact_index::Contact>& contacts);
+
+void Contact_index::update_location(const string& name, Point location)
+{
+    auto point_it = points.find(name);
+    if (point_it == points.end()) {
+        point_it = points.insert(Points_t::value_type(name, location)).first;
+        cells[get_cell(location)].push_back(&*point_it);
+    }
+    else {
+        if (get_cell(point_it->second) != get_cell(location)) {
+            remove_from_cell(&*point_it);
+            cells[get_cell(location)].push_back(&*point_it);
+        }
+        point_it->second = location;
+    }
+    generation++;
+}
+
+void Contact_index::update_remove(const string& name)
+{
+    auto point_it = points.find(name);
+    if (point_it == points.end())
+        return;
+    remove_from_cell(&*point_it);
+    points.erase(point_it);
+    contact_lists.erase(name);
+    generation++;
+}
+
+void Contact_index::clear()
+{
+    points.clear();
+    cells.clear();
+    contact_lists.clear();
+    generation++;
+}
+
+// The cached lists are out of date once ranges are measured differently.
+void Contact_index::set_geo_projection(const Geo_projection* projection)
+{
+    geographic = projection != nullptr;
+    if (projection)
+        geo_projection = *projection;
+    generation++;
+}
+
+void Contact_index::find(const string& ownship, double min_range, double max_range,
+                         double from_bearing, double width, vector<Contact>& contacts)
+{
+    contacts.clear();
+    const vector<Contact>& sorted = get_contacts(ownship, max_range);
+    from_bearing = fmod(from_bearing, 360.);
+    if (from_bearing < 0.)
+        from_bearing += 360.;
+    double to_bearing = from_bearing + std::min(width, 360.);
+    auto first = lower_bound(sorted.begin(), sorted.end(), from_bearing, bearing_less);
+    if (to_bearing <= 360.) {
+        auto last = lower_bound(first, sorted.end(), to_bearing, bearing_less);
+        append_in_range(first, last, min_range, max_range, contacts);
+        return;
+    }
+    // the sector wraps around north
+    append_in_range(first, sorted.end(), min_range, max_range, contacts);
+    auto last = lower_bound(sorted.begin(), first, to_bearing - 360., bearing_less);
+    append_in_range(sorted.begin(), last, min_range, max_range, contacts);
+}
+
+Contact_index::Cell_t Contact_index::get_cell(Point p)
+{
+    return Cell_t(long(floor(p.x / contact_cell_size_c)), long(floor(p.y / contact_cell_size_c)));
+}
+
+void Contact_index::remove_from_cell(const Points_t::value_type* point_ptr)
+{
+    auto cell_it = cells.find(get_cell(point_ptr->second));
+    vector<const Points_t::value_type*>& cell = cell_it->second;
+    cell.erase(remove(cell.begin(), cell.end(), point_ptr), cell.end());
+    if (cell.empty())
+        cells.erase(cell_it);
+}
+
+const vector<Contact_index::Contact>& Contact_index::get_contacts(const string& ownship, double range)
+{
+    // a new list is value-initialized, so it has generation 0 and range 0
+    Contact_list& list = contact_lists[ownship];
+    if (list.generation == generation && list.range >= range)
+        return list.contacts;
+    list.generation = generation;
+    list.range = range;
+    list.contacts.clear();
+    auto own_it = points.find(ownship);
+    if (own_it == points.end())
+        return list.contacts;
+    if (geographic)
+        find_geo_contacts(own_it->second, range, list.contacts);
+    else
+        find_plane_contacts(own_it->second, range, list.contacts);
+    sort(list.contacts.begin(), list.contacts.end(), contact_less);
+    return list.contacts;
+}
+
+void Contact_index::find_plane_contacts(Point own_location, double range, vector<Contact>& contacts) const
+{
+    Cell_t first = get_cell(Point(own_location.x - range, own_location.y - range));
+    Cell_t last = get_cell(Point(own_location.x + range, own_location.y + range));
+    for (long x = first.first; x <= last.first; x++) {
+        for (long y = first.second; y <= last.second; y++) {
+            auto cell_it = cells.find(Cell_t(x, y));
+            if (cell_it == cells.end())
+                continue;
+            for (auto point_ptr : cell_it->second) {
+                Compass_position relative_position(own_location, point_ptr->second);
+                if (relative_position.range > range)
+                    continue;
+                Contact contact = {relative_position.bearing, relative_position.range, &point_ptr->first};
+                contacts.push_back(contact);
+            }
+        }
+    }
+}
+
+// The positions are worked out again only after locations have changed, once for all
+// the ownships.
+void Contact_index::find_geo_contacts(Point own_location, double range, vector<Contact>& contacts)
+{
+    if (geo_generation != generation) {
+        geo_positions.clear();
+        geo_points.clear();
+        for (auto& point_pair : points) {
+            geo_positions.push_back(geo_projection.to_geo_position(point_pair.second));
+            geo_points.push_back(&point_pair);
+        }
+        geo_generation = generation;
+    }
+    Geo_position own_position = geo_projection.to_geo_position(own_location);
+    great_circle_range_query(own_position, geo_positions.data(), geo_positions.size(), range,
+                             in_range, in_range_ranges);
+    for (size_t i = 0; i < in_range.size(); i++) {
+        size_t index = in_range[i];
+        Contact contact = {great_circle_bearing(own_position, geo_positions[index]),
+            in_range_ranges[i], &geo_points[index]->first};
+        contacts.push_back(contact);
+    }
+}
+
+static bool bearing_less(const Contact_index::Contact& contact, double bearing)
+{
+    return contact.bearing < bearing;
+}
+
+static bool contact_less(const Contact_index::Contact& c1, const Contact_index::Contact& c2)
+{
+    return c1.bearing < c2.bearing;
+}
+
+static void append_in_range(vector<Contact_index::Contact>::const_iterator first,
+                            vector<Contact_index::Contact>::const_iterator last,
+                            double min_range, double max_range,
+                            vector<Contact_index::Contact>& contacts)
+{
+    for (; first != last; ++first) {
+        if (first->range >= min_range && first->range <= max_range)
+            contacts.push_back(*first);
+    }
+}
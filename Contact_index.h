@@ -0,0 +1,93 @@
+#ifndef CONTACT_INDEX_H
+#define CONTACT_INDEX_H
+
+#include "View.h"
+#include "Geometry.h"
+#include "Navigation.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+A Contact_index keeps the locations of all objects and answers queries for the
+contacts around an ownship - their bearing and range from it - in a sector of
+bearings and a band of ranges. It is attached to the Model like a View, but draws
+nothing; Bridge_views share one index rather than each keeping every location.
+
+Objects are kept in the cells of a uniform grid, so only the cells near the ownship
+are searched. The contacts of each ownship are computed once after each change of
+locations, sorted by bearing, and kept until the next change; a query then finds
+its sector by binary search. A sector may be as wide as 360 degrees, and queries
+for several range rings around the same ownship share the same list.
+
+In geographic mode, bearings and ranges are along great circles. The grid of projected
+Points does not bound a great-circle range away from the reference latitude, so the
+positions of all objects are kept in one array instead, and each ownship's contacts are
+found with a batch range query over it.
+*/
+
+class Contact_index : public View {
+public:
+	struct Contact {
+		double bearing;
+		double range;
+		const std::string* name;	// points to a name owned by the index
+	};
+
+	Contact_index() : generation(0), geographic(false), geo_generation(0) {}
+
+	void update_location(const std::string& name, Point location) override;
+
+	// Remove the object; no error if the name is not present.
+	void update_remove(const std::string& name) override;
+
+	// there is nothing to draw
+	void draw_on(std::ostream&) override {}
+
+	void clear() override;
+
+	// the Model's projection in geographic mode, or nullptr for plane sailing
+	void set_geo_projection(const Geo_projection* projection);
+
+	// Store into contacts the objects whose range from the ownship is in
+	// [min_range, max_range] and whose bearing is in the sector that runs clockwise for
+	// width degrees from from_bearing, in order of bearing from from_bearing.
+	// The ownship itself is at range 0. No contacts are found if the ownship is unknown.
+	void find(const std::string& ownship, double min_range, double max_range,
+		double from_bearing, double width, std::vector<Contact>& contacts);
+
+private:
+	typedef std::pair<long, long> Cell_t;
+	typedef std::map<std::string, Point> Points_t;
+	struct Contact_list {
+		unsigned long generation;	// of the locations the list was computed from
+		double range;				// the list has all contacts out to this range
+		std::vector<Contact> contacts;	// in order of bearing
+	};
+
+	unsigned long generation;	// incremented whenever a location changes
+	Points_t points;
+	std::map<Cell_t, std::vector<const Points_t::value_type*> > cells;
+	std::map<std::string, Contact_list> contact_lists;
+	bool geographic;
+	Geo_projection geo_projection;
+	// in geographic mode, the position of each object, as of the generation
+	unsigned long geo_generation;
+	std::vector<Geo_position> geo_positions;
+	std::vector<const Points_t::value_type*> geo_points;	// in the same order
+	// the results of each range query, reused
+	std::vector<std::size_t> in_range;
+	std::vector<double> in_range_ranges;
+
+	static Cell_t get_cell(Point p);
+	void remove_from_cell(const Points_t::value_type* point_ptr);
+	// the contacts of the ownship out to at least the range, up to date
+	const std::vector<Contact>& get_contacts(const std::string& ownship, double range);
+	// append the contacts within the range of the location in the plane, or along great circles
+	void find_plane_contacts(Point own_location, double range, std::vector<Contact>& contacts) const;
+	void find_geo_contacts(Point own_location, double range, std::vector<Contact>& contacts);
+};
+
+#endif
@@ -7,35 +7,121 @@
 #include "Geometry.h"
 #include "Ship_factory.h"
 #include "Utility.h"
+#include "Interest.h"
+#include "Contact_index.h"
+#include "Render_pipeline.h"
+#include "Output_sink.h"
+#include "Log.h"
+#include "Telemetry_view.h"
+#include "Checkpoint.h"
+#include "Journal.h"
+#include "History.h"
+#include "Trail_recorder.h"
+#include "Ensemble.h"
+#include "Fork.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <cstdlib>
+#include <cctype>
 #include <utility>
 #include <algorithm>
 #include <functional>
 
 using std::string;
-using std::cout; using std::cin; using std::endl;
-using std::map;
+using std::cin; using std::endl;
+using std::map; using std::make_pair;
 using std::shared_ptr;
-using std::for_each; using std::find_if;
-using std::mem_fn;
+using std::find_if;
+using std::vector;
+using std::set;
+using std::pair;
 
-Controller::Controller()
+// the attributes each kind of view is told about
+const unsigned map_view_attributes_c = LOCATION_ATTRIBUTE;
+const unsigned sailing_view_attributes_c = FUEL_ATTRIBUTE | COURSE_ATTRIBUTE | SPEED_ATTRIBUTE |
+    TYPE_ATTRIBUTE;
+const unsigned bridge_view_attributes_c = LOCATION_ATTRIBUTE | COURSE_ATTRIBUTE;
+const unsigned density_view_attributes_c = LOCATION_ATTRIBUTE;
+const unsigned contact_index_attributes_c = LOCATION_ATTRIBUTE;
+const unsigned trail_recorder_attributes_c = LOCATION_ATTRIBUTE;
+// the kinds of views in a checkpoint
+enum Saved_view_e {SAVED_MAP_VIEW, SAVED_SAILING_VIEW, SAVED_BRIDGE_VIEW, SAVED_DENSITY_VIEW};
+// the default budgets for the history, in megabytes
+const int history_memory_budget_c = 64;
+const int history_disk_budget_c = 256;
+const std::size_t bytes_per_megabyte_c = 1 << 20;
+// commands that change nothing a recovery needs, or control the journal itself
+const set<string> unjournaled_commands_c = {"show", "status", "export", "export_fit", "history", "ensemble",
+    "fork", "fork_results",
+    "open_telemetry", "close_telemetry", "open_journal", "close_journal", "recover"};
+
+Controller::Controller() : Controller(Model::get_instance(), cin)
+{
+}
+
+Controller::Controller(Model& model_, std::istream& is_) :
+    model(model_), is(is_), os(model_.get_output()),
+    map_view_scoped(false), map_view_trails(false), output_sink_ptr(new Output_sink(os)),
+    history_memory_budget(history_memory_budget_c * bytes_per_megabyte_c),
+    history_disk_budget(history_disk_budget_c * bytes_per_megabyte_c), n_forks_started(0)
 {
     commands_map["open_map_view"] = &Controller::open_map_view;
     commands_map["close_map_view"] = &Controller::close_map_view;
     commands_map["open_sailing_view"] = &Controller::open_sailing_view;
     commands_map["close_sailing_view"] = &Controller::close_sailing_view;
+    commands_map["sailing_sort"] = &Controller::set_sailing_sort;
+    commands_map["sailing_filter"] = &Controller::set_sailing_filter;
+    commands_map["sailing_type"] = &Controller::set_sailing_type;
+    commands_map["sailing_top"] = &Controller::set_sailing_top;
+    commands_map["sailing_page"] = &Controller::set_sailing_page;
     commands_map["open_bridge_view"] = &Controller::open_bridge_view;
     commands_map["close_bridge_view"] = &Controller::close_bridge_view;
+    commands_map["open_density_view"] = &Controller::open_density_view;
+    commands_map["close_density_view"] = &Controller::close_density_view;
+    commands_map["density_zoom"] = &Controller::set_density_zoom;
+    commands_map["density_pan"] = &Controller::set_density_origin;
+    commands_map["open_telemetry"] = &Controller::open_telemetry;
+    commands_map["close_telemetry"] = &Controller::close_telemetry;
+    commands_map["save"] = &Controller::save_checkpoint;
+    commands_map["load"] = &Controller::load_checkpoint;
+    commands_map["open_journal"] = &Controller::open_journal;
+    commands_map["close_journal"] = &Controller::close_journal;
+    commands_map["recover"] = &Controller::recover;
+    commands_map["open_history"] = &Controller::open_history;
+    commands_map["close_history"] = &Controller::close_history;
+    commands_map["history_budget"] = &Controller::set_history_budget;
+    commands_map["seek"] = &Controller::seek_history;
+    commands_map["open_trails"] = &Controller::open_trails;
+    commands_map["close_trails"] = &Controller::close_trails;
+    commands_map["map_trails"] = &Controller::set_map_trails;
+    commands_map["history"] = &Controller::show_trail;
+    commands_map["ensemble"] = &Controller::run_ensemble_scripts;
+    commands_map["fork"] = &Controller::start_fork;
+    commands_map["fork_results"] = &Controller::report_forks;
     
     commands_map["default"] = &Controller::restore_default_map;
     commands_map["size"] = &Controller::set_map_size;
     commands_map["zoom"] = &Controller::set_map_scale;
     commands_map["pan"] = &Controller::set_map_origin;
+    commands_map["live"] = &Controller::set_map_live;
+    commands_map["async_render"] = &Controller::set_async_render;
+    commands_map["flush_policy"] = &Controller::set_flush_policy;
+    commands_map["output_writer"] = &Controller::set_output_writer;
+    commands_map["log"] = &Controller::set_log;
+    commands_map["map_scope"] = &Controller::set_map_scope;
+    commands_map["export"] = &Controller::export_map_image;
+    commands_map["export_fit"] = &Controller::export_fitted_map_image;
     commands_map["show"] = &Controller::draw_map;
     commands_map["status"] = &Controller::show_object_status;
     commands_map["go"] = &Controller::update_all_objects;
     commands_map["create"] = &Controller::create_new_ship;
+    commands_map["collisions"] = &Controller::set_collision_distance;
+    commands_map["routing"] = &Controller::set_obstacle_radius;
+    commands_map["currents"] = &Controller::set_currents;
+    commands_map["geographic"] = &Controller::set_geographic_mode;
+    commands_map["plane_sailing"] = &Controller::set_plane_sailing_mode;
     
     commands_map["course"] = &Controller::set_ship_course;
     commands_map["position"] = &Controller::set_ship_to_position;
@@ -51,55 +137,206 @@ Controller::Controller()
 
 void Controller::run()
 {
-    string first_word, command;
+    // main can't be changed, so the log settings are taken from the environment
+    try {
+        unsigned log_categories = model.get_log_categories();
+        read_log_environment(log_categories);
+        model.set_log_categories(log_categories);
+    } catch (Error& error) {
+        os << error.what() << endl;
+    }
+    // and so is a journal to recover from, if it exists, and then keep
+    if (const char* journal_name = std::getenv("P5_JOURNAL")) {
+        try {
+            if (std::ifstream(journal_name))
+                replay_journal(journal_name);
+            journal_ptr.reset(new Journal(is, stdin, journal_name));
+        } catch (Error& error) {
+            os << error.what() << endl;
+        }
+    }
+    run_commands();
+}
+
+void Controller::run_commands()
+{
+    string first_word;
     while (true) {
-        cout << "\nTime " << Model::get_instance().get_time() << ": Enter command: ";
-        cin >> first_word;
-        if (first_word == "quit") {
+        os << "\nTime " << model.get_time() << ": Enter command: ";
+        mark_output_boundary(&Output_sink::end_of_command);
+        if (journal_ptr)
+            journal_ptr->start_command();
+        if (!(is >> first_word) || first_word == "quit") {
             quit();
             return;
         }
+        int time = model.get_time();
         try {
-            if (Model::get_instance().is_ship_present(first_word)) {
-                target_ship = Model::get_instance().get_ship_ptr(first_word);
-                cin >> command;
-            }
-            else
-                command = first_word;
-            auto cfp = commands_map[command];
-            if (cfp)
-                (this->*cfp)();
-            else {
-                commands_map.erase(command);
-                cout << "Unrecognized command!" << endl;
-                discard_input_remainder();
-            }
-        } catch (Error& error) {
-            cout << error.what() << endl;
-            discard_input_remainder();
+            if (execute_command(first_word) && journal_ptr && !unjournaled_commands_c.count(first_word))
+                journal_ptr->accept_command(time);
         } catch (...) {
-            cout << "Unknown exception caught." << endl;
+            os << "Unknown exception caught." << endl;
             return;
         }
-        target_ship.reset();
     }
 }
 
+// execute the command that starts with the word, returning whether it was accepted
+bool Controller::execute_command(const string& first_word)
+{
+    string command;
+    bool accepted = false;
+    try {
+        if (model.is_ship_present(first_word)) {
+            target_ship = model.get_ship_ptr(first_word);
+            is >> command;
+        }
+        else
+            command = first_word;
+        auto cfp = commands_map[command];
+        if (cfp) {
+            (this->*cfp)();
+            accepted = true;
+        }
+        else {
+            commands_map.erase(command);
+            os << "Unrecognized command!" << endl;
+            discard_input_remainder();
+        }
+    } catch (Error& error) {
+        os << error.what() << endl;
+        discard_input_remainder();
+    }
+    target_ship.reset();
+    return accepted;
+}
+
 void Controller::open_map_view()
 {
     if (map_view_ptr)
         throw Error("Map view is already open!");
     map_view_ptr.reset(new Map_view);
     draw_view_order.push_back(map_view_ptr);
-    Model::get_instance().attach(map_view_ptr);
+    map_view_scoped = false;
+    map_view_trails = false;
+    model.attach(map_view_ptr, Interest_region(map_view_attributes_c));
 }
 
 void Controller::close_map_view()
 {
     check_map_view_exist();
-    Model::get_instance().detach(map_view_ptr);
+    map_view_ptr->end_live_screen(os);
+    model.detach(map_view_ptr);
     remove_view(map_view_ptr);
     map_view_ptr.reset();
+    map_view_trails = false;
+}
+
+// open_trails <hours>
+void Controller::open_trails()
+{
+    if (trail_recorder_ptr)
+        throw Error("Trails are already open!");
+    int hours = read_int();
+    if (hours <= 0)
+        throw Error("Trail length must be positive!");
+    trail_recorder_ptr.reset(new Trail_recorder(hours, model.get_time()));
+    model.attach(trail_recorder_ptr, Interest_region(trail_recorder_attributes_c));
+}
+
+void Controller::close_trails()
+{
+    if (!trail_recorder_ptr)
+        throw Error("Trails are not open!");
+    if (map_view_trails && map_view_ptr)
+        map_view_ptr->set_trails(nullptr);
+    map_view_trails = false;
+    model.detach(trail_recorder_ptr);
+    trail_recorder_ptr.reset();
+}
+
+void Controller::set_map_trails()
+{
+    check_map_view_exist();
+    bool on = read_on_off();
+    if (on && !trail_recorder_ptr)
+        throw Error("Trails are not open!");
+    map_view_trails = on;
+    map_view_ptr->set_trails(on ? trail_recorder_ptr : nullptr);
+}
+
+// ensemble <script> ... runs the scripts, each in a Model of its own
+void Controller::run_ensemble_scripts()
+{
+    vector<string> scripts;
+    for (int c = is.peek(); c != '\n' && c != std::istream::traits_type::eof(); c = is.peek()) {
+        if (isspace(c))
+            is.get();
+        else
+            scripts.push_back(read_string());
+    }
+    if (scripts.empty())
+        throw Error("Expected script file names!");
+    // the runs write nothing here until they are all done
+    if (render_pipeline_ptr)
+        render_pipeline_ptr->drain();
+    for (auto& summary : run_ensemble(scripts, model.get_log_categories())) {
+        os << summary.script << ": ";
+        if (summary.error)
+            os << summary.error << endl;
+        else
+            os << "time " << summary.time << ", " << summary.n_ships << " ships, output in "
+                << summary.output_filename << endl;
+    }
+}
+
+// fork <updates> <order>; <order>; ... runs a copy of the simulation with the orders,
+// in the background
+void Controller::start_fork()
+{
+    int n_updates = read_int();
+    if (n_updates < 0)
+        throw Error("Number of updates must not be negative!");
+    string line;
+    getline(is, line);
+    vector<string> orders;
+    std::istringstream line_stream(line);
+    for (string order; getline(line_stream, order, ';');) {
+        string::size_type first = order.find_first_not_of(" \t");
+        if (first != string::npos)
+            orders.push_back(order.substr(first, order.find_last_not_of(" \t") + 1 - first));
+    }
+    shared_ptr<Checkpoint> checkpoint(new Checkpoint);
+    model.save(*checkpoint);
+    // forks from the same state share the run without orders
+    if (!fork_baseline_ptr || !fork_baseline_ptr->get_checkpoint().is_same_as(*checkpoint))
+        fork_baseline_ptr.reset(new Fork_baseline(checkpoint));
+    fork_container.push_back(make_pair(++n_forks_started,
+        shared_ptr<Fork>(new Fork(fork_baseline_ptr, orders, n_updates))));
+    os << "Fork " << n_forks_started << " started at time " << model.get_time() << endl;
+}
+
+// wait for the forks to finish, and report and forget them
+void Controller::report_forks()
+{
+    for (auto& fork_pair : fork_container) {
+        os << "Fork " << fork_pair.first << ":" << endl;
+        for (auto& line : fork_pair.second->get_report())
+            os << "  " << line << endl;
+    }
+    fork_container.clear();
+    fork_baseline_ptr.reset();
+}
+
+// history <ship> prints the vertices of the ship's trail
+void Controller::show_trail()
+{
+    if (!trail_recorder_ptr)
+        throw Error("Trails are not open!");
+    shared_ptr<Ship> ship_ptr = model.get_ship_ptr(read_string());
+    os << "Trail of " << ship_ptr->get_name() << ":" << endl;
+    for (auto& vertex : trail_recorder_ptr->get_trail(ship_ptr->get_name()))
+        os << "Time " << vertex.time << " " << vertex.location << endl;
 }
 
 void Controller::open_sailing_view()
@@ -108,29 +345,92 @@ void Controller::open_sailing_view()
         throw Error("Sailing data view is already open!");
     sailing_view_ptr.reset(new Sailing_view);
     draw_view_order.push_back(sailing_view_ptr);
-    Model::get_instance().attach(sailing_view_ptr);
+    model.attach(sailing_view_ptr,
+        Interest_region(sailing_view_attributes_c));
 }
 
 void Controller::close_sailing_view()
 {
-    if (!sailing_view_ptr)
-        throw Error("Sailing data view is not open!");
-    Model::get_instance().detach(sailing_view_ptr);
+    check_sailing_view_exist();
+    model.detach(sailing_view_ptr);
     remove_view(sailing_view_ptr);
     sailing_view_ptr.reset();
 }
 
+void Controller::set_sailing_sort()
+{
+    check_sailing_view_exist();
+    string key_word = read_string();
+    Sailing_view::Sort_key_e sort_key;
+    if (key_word == "name")
+        sort_key = Sailing_view::SORT_BY_NAME;
+    else if (key_word == "fuel")
+        sort_key = Sailing_view::SORT_BY_FUEL;
+    else if (key_word == "course")
+        sort_key = Sailing_view::SORT_BY_COURSE;
+    else if (key_word == "speed")
+        sort_key = Sailing_view::SORT_BY_SPEED;
+    else
+        throw Error("Expected name, fuel, course, or speed!");
+    string order_word = read_string();
+    if (order_word != "ascending" && order_word != "descending")
+        throw Error("Expected ascending or descending!");
+    sailing_view_ptr->set_sort(sort_key, order_word == "descending");
+}
+
+void Controller::set_sailing_filter()
+{
+    check_sailing_view_exist();
+    string word = read_string();
+    if (word == "all")
+        sailing_view_ptr->set_filter(Sailing_view::ALL_SHIPS);
+    else if (word == "moving")
+        sailing_view_ptr->set_filter(Sailing_view::MOVING_SHIPS);
+    else if (word == "stopped")
+        sailing_view_ptr->set_filter(Sailing_view::STOPPED_SHIPS);
+    else
+        throw Error("Expected all, moving, or stopped!");
+}
+
+// list only the ships of the type, or of every type for all
+void Controller::set_sailing_type()
+{
+    check_sailing_view_exist();
+    string word = read_string();
+    sailing_view_ptr->set_type_filter(word == "all" ? string() : word);
+}
+
+// list only the first k ships, or all of them if k is 0
+void Controller::set_sailing_top()
+{
+    check_sailing_view_exist();
+    sailing_view_ptr->set_page(read_int(), 1);
+}
+
+void Controller::set_sailing_page()
+{
+    check_sailing_view_exist();
+    int page_size = read_int();
+    sailing_view_ptr->set_page(page_size, read_int());
+}
+
 void Controller::open_bridge_view()
 {
     string ship_name = read_string();
-    if (!Model::get_instance().is_ship_present(ship_name))
+    if (!model.is_ship_present(ship_name))
         throw Error("Ship not found!");
     if (bridge_view_container.find(ship_name) != bridge_view_container.end())
         throw Error("Bridge view is already open for that ship!");
-    shared_ptr<Bridge_view> new_bridge_view(new Bridge_view(ship_name));
+    if (!contact_index_ptr) {
+        contact_index_ptr.reset(new Contact_index);
+        contact_index_ptr->set_geo_projection(model.get_geo_projection());
+        model.attach(contact_index_ptr, Interest_region(contact_index_attributes_c));
+    }
+    shared_ptr<Bridge_view> new_bridge_view(new Bridge_view(ship_name, contact_index_ptr));
     bridge_view_container[ship_name] = new_bridge_view;
     draw_view_order.push_back(new_bridge_view);
-    Model::get_instance().attach(new_bridge_view);
+    model.attach(new_bridge_view,
+        Interest_region(bridge_view_attributes_c));
 }
 
 
@@ -140,26 +440,352 @@ void Controller::close_bridge_view()
     auto bridge_view_it = bridge_view_container.find(ship_name);
     if (bridge_view_it == bridge_view_container.end())
     	throw Error("Bridge view for that ship is not open!");
-    Model::get_instance().detach(bridge_view_it->second);
+    model.detach(bridge_view_it->second);
     remove_view(bridge_view_it->second);
     bridge_view_container.erase(bridge_view_it);
+    if (bridge_view_container.empty()) {
+        model.detach(contact_index_ptr);
+        contact_index_ptr.reset();
+    }
+}
+
+
+
+void Controller::open_density_view()
+{
+    if (density_view_ptr)
+        throw Error("Density view is already open!");
+    density_view_ptr.reset(new Density_view);
+    draw_view_order.push_back(density_view_ptr);
+    model.attach(density_view_ptr, Interest_region(density_view_attributes_c));
+}
+
+void Controller::close_density_view()
+{
+    check_density_view_exist();
+    model.detach(density_view_ptr);
+    remove_view(density_view_ptr);
+    density_view_ptr.reset();
+}
+
+void Controller::set_density_zoom()
+{
+    check_density_view_exist();
+    int level;
+    if (!(is >> level))
+        throw Error("Expected an integer!");
+    density_view_ptr->set_zoom_level(level);
 }
 
+void Controller::set_density_origin()
+{
+    check_density_view_exist();
+    density_view_ptr->set_origin(read_point());
+}
 
+void Controller::open_telemetry()
+{
+    if (telemetry_view_ptr)
+        throw Error("Telemetry is already open!");
+    telemetry_view_ptr.reset(new Telemetry_view(read_string()));
+    model.attach(telemetry_view_ptr);
+    // record the state the objects start from
+    telemetry_view_ptr->update_tick(model.get_time());
+}
+
+// the changes since the last update are recorded at the current time
+void Controller::close_telemetry()
+{
+    if (!telemetry_view_ptr)
+        throw Error("Telemetry is not open!");
+    telemetry_view_ptr->update_tick(model.get_time());
+    model.detach(telemetry_view_ptr);
+    telemetry_view_ptr.reset();
+}
+
+// The views are saved in the order they are drawn.
+void Controller::save_checkpoint()
+{
+    string filename = read_string();
+    Checkpoint checkpoint;
+    model.save(checkpoint);
+    Checkpoint_writer views_writer;
+    views_writer.put_unsigned(draw_view_order.size());
+    for (auto& view : draw_view_order) {
+        if (view == map_view_ptr) {
+            views_writer.put_unsigned(SAVED_MAP_VIEW);
+            map_view_ptr->save_settings(views_writer);
+            views_writer.put_bool(map_view_scoped);
+        }
+        else if (view == sailing_view_ptr) {
+            views_writer.put_unsigned(SAVED_SAILING_VIEW);
+            sailing_view_ptr->save_settings(views_writer);
+        }
+        else if (view == density_view_ptr) {
+            views_writer.put_unsigned(SAVED_DENSITY_VIEW);
+            density_view_ptr->save_settings(views_writer);
+        }
+        else {
+            auto bridge_view_it = find_if(bridge_view_container.begin(), bridge_view_container.end(),
+                [&view](const map<string, shared_ptr<Bridge_view>>::value_type& bridge_pair)
+                    {return bridge_pair.second == view;});
+            views_writer.put_unsigned(SAVED_BRIDGE_VIEW);
+            views_writer.put_string(bridge_view_it->first);
+        }
+    }
+    checkpoint.set_section(VIEWS_SECTION, views_writer.get_bytes());
+    checkpoint.save(filename);
+}
+
+// The saved views are set up before anything is changed, so that nothing changes if
+// the checkpoint is invalid; once the Model is restored, they replace the open views.
+void Controller::load_checkpoint()
+{
+    string filename = read_string();
+    Checkpoint checkpoint;
+    checkpoint.load(filename);
+    shared_ptr<Map_view> new_map_view;
+    bool new_map_view_scoped = false;
+    shared_ptr<Sailing_view> new_sailing_view;
+    map<string, shared_ptr<Bridge_view>> new_bridge_views;
+    shared_ptr<Contact_index> new_contact_index;
+    shared_ptr<Density_view> new_density_view;
+    vector<shared_ptr<View>> new_draw_view_order;
+    const string& views_section = checkpoint.get_section(VIEWS_SECTION);
+    Checkpoint_reader views_reader(views_section.data(), views_section.size());
+    for (unsigned n_views = views_reader.get_unsigned(); n_views > 0; n_views--) {
+        switch (views_reader.get_enum(SAVED_DENSITY_VIEW + 1)) {
+            case SAVED_MAP_VIEW:
+                if (new_map_view)
+                    throw Error("Invalid checkpoint file!");
+                new_map_view.reset(new Map_view);
+                new_map_view->load_settings(views_reader);
+                new_map_view_scoped = views_reader.get_bool();
+                new_draw_view_order.push_back(new_map_view);
+                break;
+            case SAVED_SAILING_VIEW:
+                if (new_sailing_view)
+                    throw Error("Invalid checkpoint file!");
+                new_sailing_view.reset(new Sailing_view);
+                new_sailing_view->load_settings(views_reader);
+                new_draw_view_order.push_back(new_sailing_view);
+                break;
+            case SAVED_BRIDGE_VIEW: {
+                string ship_name = views_reader.get_string();
+                if (!new_contact_index)
+                    new_contact_index.reset(new Contact_index);
+                shared_ptr<Bridge_view> new_bridge_view(new Bridge_view(ship_name, new_contact_index));
+                if (!new_bridge_views.insert(make_pair(ship_name, new_bridge_view)).second)
+                    throw Error("Invalid checkpoint file!");
+                new_draw_view_order.push_back(new_bridge_view);
+                break;
+            }
+            case SAVED_DENSITY_VIEW:
+                if (new_density_view)
+                    throw Error("Invalid checkpoint file!");
+                new_density_view.reset(new Density_view);
+                new_density_view->load_settings(views_reader);
+                new_draw_view_order.push_back(new_density_view);
+                break;
+        }
+    }
+    views_reader.check_end();
+    
+    // the views are detached first, so that only the new ones are sent the loaded objects
+    for (auto& view : draw_view_order)
+        model.detach(view);
+    if (contact_index_ptr)
+        model.detach(contact_index_ptr);
+    try {
+        model.load(checkpoint);
+    } catch (...) {
+        // the model is unchanged, so the old views go on with it
+        attach_views();
+        throw;
+    }
+    if (map_view_ptr)
+        map_view_ptr->end_live_screen(os);
+    map_view_ptr = new_map_view;
+    map_view_scoped = new_map_view_scoped;
+    map_view_trails = map_view_trails && map_view_ptr;
+    if (map_view_trails)
+        map_view_ptr->set_trails(trail_recorder_ptr);
+    sailing_view_ptr = new_sailing_view;
+    bridge_view_container.swap(new_bridge_views);
+    contact_index_ptr = new_contact_index;
+    density_view_ptr = new_density_view;
+    draw_view_order.swap(new_draw_view_order);
+    attach_views();
+}
+
+void Controller::attach_views()
+{
+    if (map_view_ptr) {
+        model.attach(map_view_ptr, Interest_region(map_view_attributes_c));
+        update_map_interest();
+    }
+    if (sailing_view_ptr)
+        model.attach(sailing_view_ptr, Interest_region(sailing_view_attributes_c));
+    if (contact_index_ptr) {
+        contact_index_ptr->set_geo_projection(model.get_geo_projection());
+        model.attach(contact_index_ptr, Interest_region(contact_index_attributes_c));
+    }
+    for (auto& bridge_pair : bridge_view_container)
+        model.attach(bridge_pair.second, Interest_region(bridge_view_attributes_c));
+    if (density_view_ptr)
+        model.attach(density_view_ptr, Interest_region(density_view_attributes_c));
+}
+
+void Controller::open_journal()
+{
+    if (journal_ptr)
+        throw Error("Journal is already open!");
+    // the journal records what is read from the standard input
+    if (&is != &cin)
+        throw Error("Cannot journal this input!");
+    journal_ptr.reset(new Journal(is, stdin, read_string()));
+}
+
+// everything accepted is committed before the journal closes
+void Controller::close_journal()
+{
+    if (!journal_ptr)
+        throw Error("Journal is not open!");
+    journal_ptr.reset();
+}
+
+void Controller::recover()
+{
+    string filename = read_string();
+    replay_journal(filename);
+}
+
+// Recovery starts from the last checkpoint in the journal - loading the last one saved,
+// or replaying the last load - and replays the commands after it, or all of them if
+// there is none, with output suppressed. Each command must have been given at the time
+// the simulation has reached, and be accepted again; otherwise the journal does not
+// belong to this simulation. A last line without its newline was never committed.
+void Controller::replay_journal(const string& filename)
+{
+    if (journal_ptr)
+        throw Error("Cannot recover while journaling!");
+    std::ifstream file(filename);
+    if (!file)
+        throw Error("Could not open journal file!");
+    vector<pair<int, string>> entries;
+    std::size_t start = 0;
+    bool start_saved = false;
+    string line;
+    while (getline(file, line) && !file.eof()) {
+        std::istringstream line_stream(line);
+        int time;
+        string text, command;
+        if (!(line_stream >> time) || line_stream.get() != ' ' || !getline(line_stream, text))
+            throw Error("Invalid journal file!");
+        std::istringstream(text) >> command;
+        if (command == "save" || command == "load") {
+            start = entries.size();
+            start_saved = command == "save";
+        }
+        entries.push_back(make_pair(time, text));
+    }
+    // a saved checkpoint is loaded, and is at the time it was saved
+    if (start_saved)
+        entries[start].second.replace(0, 4, "load");
+
+    if (render_pipeline_ptr)
+        render_pipeline_ptr->drain();
+    os.setstate(std::ios::badbit);
+    try {
+            for (std::size_t i = start; i < entries.size(); i++) {
+            if (i == start && start_saved) {
+                if (!run_command(entries[i].second) || model.get_time() != entries[i].first)
+                    throw Error("Journal does not match the simulation!");
+            }
+            else if (model.get_time() != entries[i].first || !run_command(entries[i].second))
+                throw Error("Journal does not match the simulation!");
+        }
+    } catch (...) {
+        if (render_pipeline_ptr)
+            render_pipeline_ptr->drain();
+        os.clear();
+        throw;
+    }
+    if (render_pipeline_ptr)
+        render_pipeline_ptr->drain();
+    os.clear();
+    os << "Recovered " << entries.size() - start << " commands to time "
+        << model.get_time() << endl;
+}
+
+// the command is read from the text instead of the input
+bool Controller::run_command(const string& text)
+{
+    std::istringstream command_stream(text + '\n');
+    // the input is given back however the command ends
+    struct Input_restorer {
+        std::istream& is;
+        std::streambuf* input_buf;
+        ~Input_restorer()
+            {is.rdbuf(input_buf); is.clear();}
+    } input_restorer{is, is.rdbuf(command_stream.rdbuf())};
+    is.clear();
+    string first_word;
+    is >> first_word;
+    return execute_command(first_word);
+}
+
+// the history starts with the current state
+void Controller::open_history()
+{
+    if (history_ptr)
+        throw Error("History is already open!");
+    history_ptr.reset(new History(read_string(), history_memory_budget, history_disk_budget));
+    history_ptr->record(model);
+}
+
+void Controller::close_history()
+{
+    if (!history_ptr)
+        throw Error("History is not open!");
+    history_ptr.reset();
+}
+
+// history_budget <memory megabytes> <disk megabytes>
+void Controller::set_history_budget()
+{
+    int memory_budget = read_int();
+    int disk_budget = read_int();
+    if (memory_budget < 0 || disk_budget < 0)
+        throw Error("Budget must not be negative!");
+    history_memory_budget = memory_budget * bytes_per_megabyte_c;
+    history_disk_budget = disk_budget * bytes_per_megabyte_c;
+    if (history_ptr)
+        history_ptr->set_budgets(history_memory_budget, history_disk_budget);
+}
+
+void Controller::seek_history()
+{
+    if (!history_ptr)
+        throw Error("History is not open!");
+    history_ptr->seek(read_int(), model);
+}
 
 void Controller::restore_default_map()
 {
     check_map_view_exist();
     map_view_ptr->set_defaults();
+    update_map_interest();
 }
 
 void Controller::set_map_size()
 {
     check_map_view_exist();
     int size;
-    if (!(cin >> size))
+    if (!(is >> size))
         throw Error("Expected an integer!");
     map_view_ptr->set_size(size);
+    update_map_interest();
 }
 
 void Controller::set_map_scale()
@@ -167,18 +793,114 @@ void Controller::set_map_scale()
     check_map_view_exist();
     double scale = read_double();
     map_view_ptr->set_scale(scale);
+    update_map_interest();
 }
 
 void Controller::set_map_origin()
 {
     check_map_view_exist();
     map_view_ptr->set_origin(read_point());
+    update_map_interest();
+}
+
+void Controller::set_map_live()
+{
+    check_map_view_exist();
+    bool live = read_on_off();
+    if (!live)
+        map_view_ptr->end_live_screen(os);
+    map_view_ptr->set_live(live);
+}
+
+// When scoped, the map view no longer lists the objects outside the map.
+void Controller::set_map_scope()
+{
+    check_map_view_exist();
+    map_view_scoped = read_on_off();
+    if (map_view_scoped)
+        update_map_interest();
+    else
+        model.set_interest(map_view_ptr, Interest_region(map_view_attributes_c));
+}
+
+void Controller::update_map_interest()
+{
+    if (!map_view_scoped)
+        return;
+    Point lower_left, upper_right;
+    map_view_ptr->get_display_area(lower_left, upper_right);
+    model.set_interest(map_view_ptr,
+        Interest_region::box(lower_left, upper_right, map_view_attributes_c));
+}
+
+void Controller::export_map_image()
+{
+    export_image(false);
+}
+
+void Controller::export_fitted_map_image()
+{
+    export_image(true);
 }
 
 // draw all the exist maps
 void Controller::draw_map()
 {
-    for_each(draw_view_order.begin(), draw_view_order.end(), mem_fn(&View::draw));
+    if (!render_pipeline_ptr) {
+        for (auto& view : draw_view_order)
+            view->draw_on(os);
+        return;
+    }
+    for (auto& view : draw_view_order)
+        render_pipeline_ptr->submit(*view);
+}
+
+// Unless each line is flushed, the input no longer flushes the output before each read; the
+// prompt for a command is still flushed unless the policy is to flush each tick.
+void Controller::set_flush_policy()
+{
+    string word = read_string();
+    Output_sink::Flush_policy_e policy;
+    if (word == "line")
+        policy = Output_sink::FLUSH_EACH_LINE;
+    else if (word == "command")
+        policy = Output_sink::FLUSH_EACH_COMMAND;
+    else if (word == "tick")
+        policy = Output_sink::FLUSH_EACH_TICK;
+    else
+        throw Error("Expected line, command, or tick!");
+    // nothing else may use the sink while it changes
+    if (render_pipeline_ptr)
+        render_pipeline_ptr->drain();
+    output_sink_ptr->set_flush_policy(policy);
+    is.tie(policy == Output_sink::FLUSH_EACH_LINE ? &os : nullptr);
+}
+
+void Controller::set_output_writer()
+{
+    bool on = read_on_off();
+    if (render_pipeline_ptr)
+        render_pipeline_ptr->drain();
+    output_sink_ptr->set_writer_thread(on);
+}
+
+// log <category> on|off, or log all on|off
+void Controller::set_log()
+{
+    string name = read_string();
+    bool enabled = read_on_off();
+    unsigned categories = name == "all" ? all_log_categories_c : 1u << get_log_category(name);
+    unsigned log_categories = model.get_log_categories();
+    model.set_log_categories(enabled ? log_categories | categories : log_categories & ~categories);
+}
+
+// Off waits for everything already shown to be written.
+void Controller::set_async_render()
+{
+    if (!read_on_off())
+        render_pipeline_ptr.reset();
+    else if (!render_pipeline_ptr)
+        render_pipeline_ptr.reset(new Render_pipeline(os));
 }
 
 void Controller::check_map_view_exist()
@@ -187,14 +909,52 @@ void Controller::check_map_view_exist()
         throw Error("Map view is not open!");
 }
 
+// read the file name and image size, then have the map view write the image
+void Controller::export_image(bool fit)
+{
+    check_map_view_exist();
+    string filename = read_string();
+    int pixels;
+    if (!(is >> pixels))
+        throw Error("Expected an integer!");
+    map_view_ptr->export_image(filename, pixels, fit);
+}
+
+void Controller::check_density_view_exist()
+{
+    if (!density_view_ptr)
+        throw Error("Density view is not open!");
+}
+
+// While views are being drawn in the background, the sink is told of the boundary
+// only after the output produced before it has reached the sink.
+void Controller::mark_output_boundary(void (Output_sink::*boundary)())
+{
+    if (render_pipeline_ptr)
+        render_pipeline_ptr->call_in_order(std::bind(boundary, output_sink_ptr));
+    else
+        ((*output_sink_ptr).*boundary)();
+}
+
+void Controller::check_sailing_view_exist()
+{
+    if (!sailing_view_ptr)
+        throw Error("Sailing data view is not open!");
+}
+
 void Controller::show_object_status()
 {
-    Model::get_instance().describe();
+    model.describe();
 }
 
 void Controller::update_all_objects()
 {
-    Model::get_instance().update();
+    model.update();
+    if (history_ptr)
+        history_ptr->record(model);
+    if (map_view_ptr && map_view_ptr->is_live())
+        map_view_ptr->draw_live(os);
+    mark_output_boundary(&Output_sink::end_of_tick);
 }
 
 void Controller::create_new_ship()
@@ -202,12 +962,48 @@ void Controller::create_new_ship()
     string name = read_string();
     if (name.length() < 2)
         throw Error("Name is too short!");
-    if (Model::get_instance().is_name_in_use(name))
+    if (model.is_name_in_use(name))
         throw Error("Name is already in use!");
     string ship_type;
-    cin >> ship_type;
-    shared_ptr<Ship> new_ship = create_ship(name, ship_type, read_point());
-    Model::get_instance().add_ship(new_ship);
+    is >> ship_type;
+    shared_ptr<Ship> new_ship = create_ship(model, name, ship_type, read_point());
+    model.add_ship(new_ship);
+}
+
+void Controller::set_collision_distance()
+{
+    model.set_collision_distance(read_double());
+}
+
+void Controller::set_obstacle_radius()
+{
+    model.set_obstacle_radius(read_double());
+}
+
+// "currents off" removes the currents, otherwise the word is the field's file name
+void Controller::set_currents()
+{
+    string filename = read_string();
+    if (filename == "off")
+        model.unload_currents();
+    else
+        model.load_currents(filename);
+}
+
+void Controller::set_geographic_mode()
+{
+    double latitude = read_double();
+    double longitude = read_double();
+    model.set_geographic_mode(latitude, longitude);
+    if (contact_index_ptr)
+        contact_index_ptr->set_geo_projection(model.get_geo_projection());
+}
+
+void Controller::set_plane_sailing_mode()
+{
+    model.set_plane_sailing_mode();
+    if (contact_index_ptr)
+        contact_index_ptr->set_geo_projection(nullptr);
 }
 
 void Controller::set_ship_course()
@@ -250,7 +1046,7 @@ void Controller::set_ship_dock_island()
 void Controller::set_ship_attack_target()
 {
     string ship_name = read_string();
-    shared_ptr<Ship> attack_ship = Model::get_instance().get_ship_ptr(ship_name);
+    shared_ptr<Ship> attack_ship = model.get_ship_ptr(ship_name);
     target_ship->attack(attack_ship);
 }
 
@@ -272,7 +1068,15 @@ void Controller::set_ship_stop_attack()
 
 void Controller::quit()
 {
-    cout << "Done" << endl;
+    render_pipeline_ptr.reset();
+    if (map_view_ptr)
+        map_view_ptr->end_live_screen(os);
+    if (telemetry_view_ptr)
+        close_telemetry();
+    journal_ptr.reset();
+    fork_container.clear();
+    fork_baseline_ptr.reset();
+    os << "Done" << endl;
 }
 
 
@@ -289,8 +1093,8 @@ double Controller::read_check_speed()
 // Read to new line
 void Controller::discard_input_remainder()
 {
-    cin.clear();
-    while (cin.get() != '\n')
+    is.clear();
+    while (is.get() != '\n' && is)
         ;
 }
 
@@ -305,22 +1109,40 @@ Point Controller::read_point()
 double Controller::read_double()
 {
     double temp;
-    if (!(cin >> temp))
+    if (!(is >> temp))
         throw Error("Expected a double!");
     return temp;
 }
 
+int Controller::read_int()
+{
+    int temp;
+    if (!(is >> temp))
+        throw Error("Expected an integer!");
+    return temp;
+}
+
 string Controller::read_string()
 {
     string read_string;
-    cin>>read_string;
+    is>>read_string;
     return read_string;
 }
 
+bool Controller::read_on_off()
+{
+    string word = read_string();
+    if (word == "on")
+        return true;
+    if (word == "off")
+        return false;
+    throw Error("Expected on or off!");
+}
+
 shared_ptr<Island> Controller::read_get_island()
 {
     string island_name = read_string();
-    return Model::get_instance().get_island_ptr(island_name);
+    return model.get_island_ptr(island_name);
 }
 
 void Controller::remove_view(std::shared_ptr<View> view)
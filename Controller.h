@@ -1,20 +1,36 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
+#include <cstddef>
 #include <string>
 #include <map>
 #include <vector>
+#include <utility>
 #include <memory>
+#include <iosfwd>
 
 /* Controller
 This class is responsible for controlling the Model and View according to interactions
 with the user.
+A Controller runs one Model, reading commands from its input; its output, like the
+Model's, goes to the Model's output.
 */
 
+class Model;
 class View;
 class Map_view;
 class Sailing_view;
 class Bridge_view;
+class Contact_index;
+class Render_pipeline;
+class Output_sink;
+class Density_view;
+class Telemetry_view;
+class Journal;
+class History;
+class Trail_recorder;
+class Fork;
+class Fork_baseline;
 class Ship;
 class Island;
 class Controller;
@@ -25,15 +41,41 @@ using Command_map_t = std::map<std::string, void(Controller::*)()>;
 
 class Controller {
 public:
+    // run the program's Model with commands from cin
     Controller();
+    Controller(Model& model_, std::istream& is_);
 	// create View object, run the program by acccepting user commands, then destroy View object
 	void run();
+	// accept commands until quit or the end of the input, without the settings the
+	// program takes from the environment
+	void run_commands();
+	// execute the command in the text, as if it were the next line of the input,
+	// returning whether it was accepted
+	bool run_command(const std::string& text);
     
 private:
+    Model& model;
+    std::istream& is;
+    std::ostream& os;
     std::shared_ptr<Map_view> map_view_ptr;
+    bool map_view_scoped;	// the map view only hears about objects in its display area
+    bool map_view_trails;	// the map view draws the recorded trails
     std::shared_ptr<Sailing_view> sailing_view_ptr;
     std::map<std::string, std::shared_ptr<Bridge_view>> bridge_view_container;
+    std::shared_ptr<Contact_index> contact_index_ptr;	// shared by the bridge views
+    std::shared_ptr<Trail_recorder> trail_recorder_ptr;
+    std::shared_ptr<Density_view> density_view_ptr;
+    std::shared_ptr<Telemetry_view> telemetry_view_ptr;
+    std::shared_ptr<Journal> journal_ptr;	// accepted commands are journaled while this exists
     std::vector<std::shared_ptr<View>> draw_view_order;
+    std::shared_ptr<Output_sink> output_sink_ptr;	// all output goes through this
+    std::shared_ptr<Render_pipeline> render_pipeline_ptr;	// views are drawn in the background while this exists
+    std::shared_ptr<History> history_ptr;	// each update is recorded while this exists
+    std::size_t history_memory_budget;
+    std::size_t history_disk_budget;
+    std::vector<std::pair<int, std::shared_ptr<Fork>>> fork_container;	// by number, in order
+    int n_forks_started;
+    std::shared_ptr<Fork_baseline> fork_baseline_ptr;	// of the forks started from the latest state
     std::shared_ptr<Ship> target_ship; // ship pointer for ship commands
     Command_map_t commands_map;
     
@@ -42,15 +84,55 @@ private:
     void close_map_view();
     void open_sailing_view();
     void close_sailing_view();
+    void set_sailing_sort();
+    void set_sailing_filter();
+    void set_sailing_type();
+    void set_sailing_top();
+    void set_sailing_page();
     void open_bridge_view();
     void close_bridge_view();
+    void open_density_view();
+    void close_density_view();
+    void set_density_zoom();
+    void set_density_origin();
+    void open_telemetry();
+    void close_telemetry();
+    void save_checkpoint();
+    void load_checkpoint();
+    void open_journal();
+    void close_journal();
+    void recover();
+    void open_history();
+    void close_history();
+    void set_history_budget();
+    void seek_history();
+    void open_trails();
+    void close_trails();
+    void set_map_trails();
+    void show_trail();
+    void run_ensemble_scripts();
+    void start_fork();
+    void report_forks();
     void set_map_size();
     void set_map_scale();
     void set_map_origin();
+    void set_map_live();
+    void set_async_render();
+    void set_flush_policy();
+    void set_output_writer();
+    void set_log();
+    void set_map_scope();
+    void export_map_image();
+    void export_fitted_map_image();
     void draw_map();
     void show_object_status();
     void update_all_objects();
     void create_new_ship();
+    void set_collision_distance();
+    void set_obstacle_radius();
+    void set_currents();
+    void set_geographic_mode();
+    void set_plane_sailing_mode();
     void quit();
     
     // control ship command functions
@@ -66,11 +148,22 @@ private:
     void set_ship_stop_attack();
     
     // helper functions
+    bool execute_command(const std::string& first_word);
+    void replay_journal(const std::string& filename);
     Point read_point();
     double read_double();
+    int read_int();
     double read_check_speed();
     std::string read_string();
+    bool read_on_off();
     void check_map_view_exist();
+    void update_map_interest();
+    // attach the views that are drawn, and the contact index, to the model
+    void attach_views();
+    void check_density_view_exist();
+    void check_sailing_view_exist();
+    void mark_output_boundary(void (Output_sink::*boundary)());
+    void export_image(bool fit);
     std::shared_ptr<Island> read_get_island();
     void remove_view(std::shared_ptr<View> view);
     void discard_input_remainder();
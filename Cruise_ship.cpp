@@ -1,19 +1,48 @@
 #include "Cruise_ship.h"
+#include "Log.h"
 #include "Model.h"
 #include "Island.h"
+#include "Checkpoint.h"
 #include <iostream>
 #include <algorithm>
 #include <cassert>
 
 
-using std::cout; using std::endl;
+using std::endl;
 using std::shared_ptr;
 using std::find_if;
 
-Cruise_ship::Cruise_ship(const std::string& name_, Point position_) :
-    Ship(name_, position_, 500., 15., 2., 0), cruise_state(NO_DESTINATION)
+Cruise_ship::Cruise_ship(Model& model_, const std::string& name_, Point position_) :
+    Ship(model_, name_, position_, 500., 15., 2., 0), cruise_state(NO_DESTINATION), cruise_speed(0.)
 {
-    remaining_islands = Model::get_instance().get_all_islands();
+    remaining_islands = get_model().get_all_islands();
+}
+
+void Cruise_ship::save_state(Checkpoint_writer& writer) const
+{
+    Ship::save_state(writer);
+    writer.put_unsigned(cruise_state);
+    writer.put_object(start_island.get());
+    writer.put_object(current_destination.get());
+    writer.put_unsigned(remaining_islands.size());
+    for (auto& island_ptr : remaining_islands)
+        writer.put_object(island_ptr.get());
+    writer.put_double(cruise_speed);
+}
+
+void Cruise_ship::load_state(Checkpoint_reader& reader)
+{
+    Ship::load_state(reader);
+    cruise_state = Cruise_state_e(reader.get_enum(MOVING_TO_START_ISLAND + 1));
+    start_island = reader.get_island_ptr();
+    current_destination = reader.get_island_ptr();
+    remaining_islands.clear();
+    for (unsigned n_islands = reader.get_unsigned(); n_islands > 0; n_islands--) {
+        shared_ptr<Island> island_ptr = reader.get_island_ptr();
+        if (island_ptr)
+            remaining_islands.insert(island_ptr);
+    }
+    cruise_speed = reader.get_double();
 }
 
 void Cruise_ship::update()
@@ -35,10 +64,11 @@ void Cruise_ship::update()
         case MOVING_TO_START_ISLAND:
             if (!is_moving() && can_dock(current_destination)) {
                 dock(current_destination);
-                cout << get_name() << " cruise is over at "
-                    << start_island->get_name() << endl;
+                if (log_enabled(LOG_CRUISE))
+                    get_output() << get_name() << " cruise is over at "
+                        << start_island->get_name() << endl;
                 cruise_state = NO_DESTINATION;
-                remaining_islands = Model::get_instance().get_all_islands();
+                remaining_islands = get_model().get_all_islands();
             }
             break;
         case REFUEL:
@@ -52,8 +82,9 @@ void Cruise_ship::update()
             get_next_destination();
             Ship::set_destination_position_and_speed(current_destination->get_location(),
                                                      cruise_speed);
-            cout << get_name() << " will visit "
-                << current_destination->get_name() << endl;
+            if (log_enabled(LOG_CRUISE))
+                get_output() << get_name() << " will visit "
+                    << current_destination->get_name() << endl;
             break;
         default:
             assert(false);
@@ -61,14 +92,14 @@ void Cruise_ship::update()
     }
 }
 
-void Cruise_ship::describe() const
+void Cruise_ship::describe(std::ostream& os) const
 {
-    cout << "\nCruise_ship ";
-    Ship::describe();
+    os << "\nCruise_ship ";
+    Ship::describe(os);
     if (cruise_state == MOVING || cruise_state == MOVING_TO_START_ISLAND)
-        cout << "On cruise to " << current_destination->get_name() << endl;
+        os << "On cruise to " << current_destination->get_name() << endl;
     else if(cruise_state != NO_DESTINATION)
-        cout << "Waiting during cruise at " << current_destination->get_name() << endl;
+        os << "Waiting during cruise at " << current_destination->get_name() << endl;
 }
 
 
@@ -79,9 +110,11 @@ void Cruise_ship::set_destination_position_and_speed(Point destination, double s
     Ship::set_destination_position_and_speed(destination, speed);
     if (island_ptr) {
         cruise_state = MOVING;
-        cout << get_name() << " will visit " << island_ptr->get_name() << endl;
-        cout << get_name() <<  " cruise will start and end at "
-            << island_ptr->get_name() << endl;
+        if (log_enabled(LOG_CRUISE)) {
+            get_output() << get_name() << " will visit " << island_ptr->get_name() << endl;
+            get_output() << get_name() <<  " cruise will start and end at "
+                << island_ptr->get_name() << endl;
+        }
         cruise_speed = speed;
         start_island = island_ptr;
         current_destination = island_ptr;
@@ -107,9 +140,10 @@ void Cruise_ship::stop()
 void Cruise_ship::check_cancle_cruise()
 {
     if (cruise_state != NO_DESTINATION) {
-        cout << get_name() << " canceling current cruise" << endl;
+        if (log_enabled(LOG_CRUISE))
+            get_output() << get_name() << " canceling current cruise" << endl;
         cruise_state = NO_DESTINATION;
-        remaining_islands = Model::get_instance().get_all_islands();
+        remaining_islands = get_model().get_all_islands();
     }
 }
 
@@ -23,7 +23,7 @@ class Island;
 
 class Cruise_ship : public Ship {
 public:
-	Cruise_ship(const std::string& name_, Point position_);
+	Cruise_ship(Model& model_, const std::string& name_, Point position_);
     
     void set_destination_position_and_speed(Point destination, double speed) override;
     
@@ -33,7 +33,11 @@ public:
 	
 	void update() override;
     
-	void describe() const override;
+	void describe(std::ostream& os) const override;
+	const char* get_type_name() const override
+		{return "Cruise_ship";}
+	void save_state(Checkpoint_writer& writer) const override;
+	void load_state(Checkpoint_reader& reader) override;
     
 private:
     enum Cruise_state_e {NO_DESTINATION, MOVING, REFUEL, WAIT, FIND_NEXT_ISLAND,
@@ -1,8 +1,9 @@
 #include "Cruiser.h"
+#include "Log.h"
 #include <iostream>
 
 using std::string;
-using std::cout; using std::endl;
+using std::endl;
 
 
 void Cruiser::update()
@@ -12,16 +13,17 @@ void Cruiser::update()
         if (target_in_range())
             fire_at_target();
         else {
-            cout << get_name() << " target is out of range" << endl;
+            if (log_enabled(LOG_COMBAT))
+                get_output() << get_name() << " target is out of range" << endl;
             stop_attack();
         }
     }
 }
 
-void Cruiser::describe() const
+void Cruiser::describe(std::ostream& os) const
 {
-    cout << "\nCruiser ";
-    Warship::describe();
+    os << "\nCruiser ";
+    Warship::describe(os);
 }
 
 void Cruiser::receive_hit(int hit_force, std::shared_ptr<Ship> attacker_ptr)
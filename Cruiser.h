@@ -22,11 +22,13 @@ resistance 6, firepower 3, maximum attacking range 15
 class Cruiser : public Warship {
 public:
 	// initialize
-	Cruiser(const std::string& name_, Point position_) :
-        Warship(name_, position_, 1000., 20., 10., 6, 3, 15.) {}
+	Cruiser(Model& model_, const std::string& name_, Point position_) :
+        Warship(model_, name_, position_, 1000., 20., 10., 6, 3, 15.) {}
     
 	void update() override;
-	void describe() const override;
+	void describe(std::ostream& os) const override;
+	const char* get_type_name() const override
+		{return "Cruiser";}
     void receive_hit(int hit_force, std::shared_ptr<Ship> attacker_ptr) override;
 };
 
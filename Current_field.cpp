@@ -0,0 +1,117 @@
+#include "Current_field.h"
+#include "Utility.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using std::string;
+using std::size_t;
+using std::memcpy; using std::memcmp;
+
+const size_t header_size_c = 36;
+// the number of grid cells along each side of a tile
+const int tile_cells_c = 32;
+
+Current_field::Current_field() :
+    mapping(nullptr), mapping_size(0), data(nullptr), nx(0), ny(0),
+    origin_x(0.), origin_y(0.), cell_size(1.)
+{}
+
+Current_field::~Current_field()
+{
+    unload();
+}
+
+void Current_field::load(const string& filename)
+{
+    unload();
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw Error("Could not open current field file!");
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0 || size_t(file_stat.st_size) < header_size_c) {
+        close(fd);
+        throw Error("Invalid current field file!");
+    }
+    mapping_size = file_stat.st_size;
+    mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw Error("Could not open current field file!");
+    }
+    const char* bytes = static_cast<const char*>(mapping);
+    int32_t header_nx, header_ny;
+    memcpy(&header_nx, bytes + 4, sizeof(header_nx));
+    memcpy(&header_ny, bytes + 8, sizeof(header_ny));
+    memcpy(&origin_x, bytes + 12, sizeof(origin_x));
+    memcpy(&origin_y, bytes + 20, sizeof(origin_y));
+    memcpy(&cell_size, bytes + 28, sizeof(cell_size));
+    nx = header_nx;
+    ny = header_ny;
+    if (memcmp(bytes, "P5CF", 4) != 0 || nx < 2 || ny < 2 || !(cell_size > 0.) ||
+        mapping_size < header_size_c + 2 * sizeof(float) * size_t(nx) * size_t(ny)) {
+        unload();
+        throw Error("Invalid current field file!");
+    }
+    data = reinterpret_cast<const float*>(bytes + header_size_c);
+    loaded_filename = filename;
+}
+
+void Current_field::unload()
+{
+    if (mapping)
+        munmap(mapping, mapping_size);
+    mapping = nullptr;
+    mapping_size = 0;
+    data = nullptr;
+    loaded_filename.clear();
+}
+
+Cartesian_vector Current_field::sample(Point p) const
+{
+    Cartesian_vector drift;
+    sample(&p, &drift, 1);
+    return drift;
+}
+
+void Current_field::sample(const Point* points, Cartesian_vector* drifts, size_t n) const
+{
+    for (size_t i = 0; i < n; i++) {
+        double fx = (points[i].x - origin_x) / cell_size;
+        double fy = (points[i].y - origin_y) / cell_size;
+        if (!data || !(fx >= 0. && fx <= nx - 1 && fy >= 0. && fy <= ny - 1)) {
+            drifts[i] = Cartesian_vector();
+            continue;
+        }
+        // the last row and column are reached from the cell before them
+        int ix = (fx < nx - 1) ? int(fx) : nx - 2;
+        int iy = (fy < ny - 1) ? int(fy) : ny - 2;
+        double tx = fx - ix;
+        double ty = fy - iy;
+        const float* row0 = data + 2 * (size_t(iy) * nx + ix);
+        const float* row1 = row0 + 2 * size_t(nx);
+        double w00 = (1. - tx) * (1. - ty), w10 = tx * (1. - ty);
+        double w01 = (1. - tx) * ty, w11 = tx * ty;
+        drifts[i].delta_x = w00 * row0[0] + w10 * row0[2] + w01 * row1[0] + w11 * row1[2];
+        drifts[i].delta_y = w00 * row0[1] + w10 * row0[3] + w01 * row1[1] + w11 * row1[3];
+    }
+}
+
+// Points off the grid, where there is no current, are put in the tiles along its edge;
+// the grid coordinates are clamped first, so that they convert to whole numbers however
+// far off the grid they are.
+long Current_field::get_tile(Point p) const
+{
+    long tiles_per_row = (nx + tile_cells_c - 1) / tile_cells_c;
+    double fx = std::max(0., std::min(double(nx - 1), (p.x - origin_x) / cell_size));
+    double fy = std::max(0., std::min(double(ny - 1), (p.y - origin_y) / cell_size));
+    long tile_x = long(fx) / tile_cells_c;
+    long tile_y = long(fy) / tile_cells_c;
+    return tile_y * tiles_per_row + tile_x;
+}
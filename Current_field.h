@@ -0,0 +1,65 @@
+#ifndef CURRENT_FIELD_H
+#define CURRENT_FIELD_H
+
+#include "Geometry.h"
+#include <cstddef>
+#include <string>
+
+/*
+A Current_field is a gridded vector field of ocean currents, read from a binary file
+that is memory-mapped rather than copied, so large grids cost nothing to load and only
+the parts that ships visit are ever paged in.
+
+The file is in native byte order and consists of a 36-byte header with no padding:
+	char magic[4]				"P5CF"
+	int32 nx, ny				number of grid points in x and y
+	double origin_x, origin_y	Point of grid point (0, 0)
+	double cell_size			distance between adjacent grid points
+followed by nx * ny pairs of floats (delta_x, delta_y), the current in nm/hr at each
+grid point, in rows of increasing y, each row in order of increasing x.
+
+The current at a Point is found by bilinear interpolation of the four surrounding grid
+points. Outside the grid there is no current.
+*/
+
+class Current_field {
+public:
+	Current_field();
+	~Current_field();
+
+	// Map the file, replacing any field already loaded.
+	// will throw Error("Could not open current field file!") or
+	// Error("Invalid current field file!"); the previous field is unloaded either way
+	void load(const std::string& filename);
+	// unmap the file; no error if nothing is loaded
+	void unload();
+	bool is_loaded() const
+		{return data != nullptr;}
+	// the name of the file loaded, or the empty string
+	const std::string& get_filename() const
+		{return loaded_filename;}
+
+	// current at a single Point
+	Cartesian_vector sample(Point p) const;
+	// current at n Points, stored into drifts; the points should be ordered by
+	// get_tile so that nearby samples share cache lines
+	void sample(const Point* points, Cartesian_vector* drifts, std::size_t n) const;
+	// a key that groups Points in the same region of the grid
+	long get_tile(Point p) const;
+
+private:
+	void* mapping;
+	std::size_t mapping_size;
+	const float* data;		// nx * ny (delta_x, delta_y) pairs, or nullptr if not loaded
+	int nx, ny;
+	double origin_x, origin_y, cell_size;
+	std::string loaded_filename;
+
+	// disallow copy/move construction or assignment
+	Current_field(const Current_field&) = delete;
+	Current_field(Current_field&&) = delete;
+	Current_field& operator= (const Current_field&) = delete;
+	Current_field& operator= (Current_field&&) = delete;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "Ensemble.h"
+#include "Controller.h"
+#include "Model.h"
+#include "Utility.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+using std::string;
+using std::vector;
+
+// added to the name of a script to name its output
+const char* const output_suffix_c = ".out";
+// the precision of numbers in the output, as the program's own output has
+const int output_precision_c = 2;
+
+// run one script in a new Model
+static void run_script(Ensemble_summary& summary, unsigned log_categories)
+{
+    std::ifstream input(summary.script);
+    if (!input) {
+        summary.error = "Could not open script file!";
+        return;
+    }
+    std::ofstream output(summary.output_filename);
+    if (!output) {
+        summary.error = "Could not open output file!";
+        return;
+    }
+    output.setf(std::ios::fixed, std::ios::floatfield);
+    output.precision(output_precision_c);
+    Model model(output);
+    model.set_log_categories(log_categories);
+    {
+        Controller controller(model, input);
+        controller.run_commands();
+    }
+    summary.time = model.get_time();
+    summary.n_ships = model.get_ship_count();
+}
+
+// Each thread takes the next script not yet taken until there are none left.
+vector<Ensemble_summary> run_ensemble(const vector<string>& scripts, unsigned log_categories)
+{
+    vector<Ensemble_summary> summaries;
+    for (auto& script : scripts)
+        summaries.push_back(Ensemble_summary{script, script + output_suffix_c, nullptr, 0, 0});
+    std::atomic<std::size_t> next_script(0);
+    auto run_scripts = [&summaries, &next_script, log_categories] {
+        for (std::size_t i = next_script++; i < summaries.size(); i = next_script++)
+            run_script(summaries[i], log_categories);
+    };
+    std::size_t n_threads = std::min<std::size_t>(summaries.size(),
+                                                  std::max(1u, std::thread::hardware_concurrency()));
+    vector<std::thread> threads;
+    for (std::size_t i = 1; i < n_threads; i++)
+        threads.push_back(std::thread(run_scripts));
+    run_scripts();
+    for (auto& thread : threads)
+        thread.join();
+    return summaries;
+}
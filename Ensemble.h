@@ -0,0 +1,32 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <string>
+#include <vector>
+
+/*
+An ensemble runs several scenario scripts at once, each in a Model of its own, so that
+their outcomes can be compared. A script holds commands just as a user would type them;
+each run has a Controller that reads its script as it would read the user, until quit or
+the end of the script, and writes everything to a file named for the script with ".out"
+added. The runs are divided among as many threads as the machine has cores.
+
+Once every run has finished, each is summarized by the time it reached and the number
+of ships still afloat. Each run starts with the log categories it is given; a log
+command in its script changes them for that run alone.
+*/
+
+struct Ensemble_summary {
+	std::string script;
+	std::string output_filename;
+	const char* error;	// why the run could not be made, or nullptr
+	int time;
+	int n_ships;
+};
+
+// run the scripts, each starting with the log categories, returning a summary of each
+// in the same order
+std::vector<Ensemble_summary> run_ensemble(const std::vector<std::string>& scripts,
+	unsigned log_categories);
+
+#endif
@@ -0,0 +1,107 @@
+#include "Fixed_format.h"
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+
+using std::string;
+using std::ostream;
+
+// large enough for any value formatted by format_fast
+const int fast_buffer_size_c = 40;
+// the largest precision and scaled value formatted by format_fast; the error in
+// scaling a value below this is far less than tie_margin_c
+const int max_fast_precision_c = 9;
+const double max_fast_scaled_c = 1e12;
+// scaled values whose fractions are this close to one half are left to printf
+const double tie_margin_c = 1e-3;
+
+const double powers_of_ten_c[max_fast_precision_c + 1] =
+    {1., 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+// Format the value into the buffer and return the length, or 0 if it must be left to printf.
+// Like printf, a negative value that rounds to zero keeps its sign.
+static int format_fast(char* buffer, double value, int precision)
+{
+    if (precision < 0 || precision > max_fast_precision_c || !std::isfinite(value))
+        return 0;
+    double scaled = std::fabs(value) * powers_of_ten_c[precision];
+    if (scaled >= max_fast_scaled_c)
+        return 0;
+    double whole = std::floor(scaled);
+    double fraction = scaled - whole;
+    if (std::fabs(fraction - 0.5) < tie_margin_c)
+        return 0;
+    unsigned long long n = static_cast<unsigned long long>(whole) + (fraction > 0.5 ? 1 : 0);
+    // the digits in reverse, with at least one before the decimal point
+    char digits[fast_buffer_size_c];
+    int n_digits = 0;
+    do {
+        digits[n_digits++] = char('0' + n % 10);
+        n /= 10;
+    } while (n);
+    while (n_digits <= precision)
+        digits[n_digits++] = '0';
+    char* p = buffer;
+    if (std::signbit(value))
+        *p++ = '-';
+    for (int i = n_digits - 1; i >= precision; i--)
+        *p++ = digits[i];
+    if (precision > 0) {
+        *p++ = '.';
+        for (int i = precision - 1; i >= 0; i--)
+            *p++ = digits[i];
+    }
+    return int(p - buffer);
+}
+
+void append_fixed(string& text, double value, int precision, int width)
+{
+    char buffer[fast_buffer_size_c];
+    int length = format_fast(buffer, value, precision);
+    if (length == 0) {
+        int full_length = snprintf(nullptr, 0, "%*.*f", width, precision, value);
+        size_t start = text.size();
+        text.resize(start + full_length + 1);
+        snprintf(&text[start], full_length + 1, "%*.*f", width, precision, value);
+        text.resize(start + full_length);
+        return;
+    }
+    if (length < width)
+        text.append(width - length, ' ');
+    text.append(buffer, length);
+}
+
+void write_fixed(ostream& os, double value)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    if ((flags & std::ios_base::floatfield) != std::ios_base::fixed ||
+        (flags & std::ios_base::showpos)) {
+        os << value;
+        return;
+    }
+    char buffer[fast_buffer_size_c];
+    int length = format_fast(buffer, value, int(os.precision()));
+    if (length == 0) {
+        os << value;
+        return;
+    }
+    std::streamsize padding = os.width() > length ? os.width() - length : 0;
+    os.width(0);
+    if (padding == 0) {
+        os.write(buffer, length);
+        return;
+    }
+    std::ios_base::fmtflags adjust = flags & std::ios_base::adjustfield;
+    // internal adjustment puts the fill after the sign
+    int sign_length = (adjust == std::ios_base::internal && buffer[0] == '-') ? 1 : 0;
+    if (adjust == std::ios_base::left) {
+        os.write(buffer, length);
+        for (std::streamsize i = 0; i < padding; i++)
+            os.put(os.fill());
+        return;
+    }
+    os.write(buffer, sign_length);
+    for (std::streamsize i = 0; i < padding; i++)
+        os.put(os.fill());
+    os.write(buffer + sign_length, length - sign_length);
+}
@@ -0,0 +1,36 @@
+#ifndef FIXED_FORMAT_H
+#define FIXED_FORMAT_H
+
+#include <iosfwd>
+#include <string>
+
+/*
+Fast formatting of doubles in fixed notation - the format main sets for cout - that gives
+exactly what the stream or printf would. Most values are scaled to an integer and
+converted digit by digit; values too large for that, too close to halfway between two
+results for the scaling to be trusted, or not finite, are left to printf or the stream.
+
+write_fixed inserts a value into a stream, using the stream's precision, width, fill, and
+adjustment, as operator<< would; if the stream is not in fixed notation, or shows a plus
+sign, it simply uses operator<<. Output operators use it through Fixed_value:
+	cout << Fixed_value(fuel);
+*/
+
+// append the value with the number of decimal places, right-adjusted in the width
+void append_fixed(std::string& text, double value, int precision, int width = 0);
+
+void write_fixed(std::ostream& os, double value);
+
+struct Fixed_value {
+	double value;
+
+	explicit Fixed_value(double value_) : value(value_) {}
+};
+
+inline std::ostream& operator<< (std::ostream& os, Fixed_value fv)
+{
+	write_fixed(os, fv.value);
+	return os;
+}
+
+#endif
@@ -0,0 +1,178 @@
+#include "Fork.h"
+#include "Controller.h"
+#include "Model.h"
+#include "View.h"
+#include "Checkpoint.h"
+#include "Geometry.h"
+#include "Utility.h"
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+using std::string;
+using std::vector;
+using std::map;
+using std::shared_ptr;
+using std::lock_guard;
+using std::mutex;
+
+// the precision of numbers in the report, as in the program's own output
+const int report_precision_c = 2;
+
+// takes the state of every object from the snapshot it is sent when attached
+class State_collector : public View {
+public:
+    void update_snapshot(const vector<Object_state>& states_, unsigned) override
+    {
+        for (auto& state : states_)
+            states[state.name] = state;
+    }
+    void update_remove(const string&) override {}
+    void draw_on(std::ostream&) override {}
+    void clear() override
+        {states.clear();}
+
+    map<string, Object_state> states;
+};
+
+static map<string, Object_state> get_states(Model& model)
+{
+    shared_ptr<State_collector> collector(new State_collector);
+    model.attach(collector);
+    model.detach(collector);
+    return collector->states;
+}
+
+// the text of a number or location, as it is reported
+template <typename T>
+static string format_value(const T& value)
+{
+    std::ostringstream value_stream;
+    value_stream.setf(std::ios::fixed, std::ios::floatfield);
+    value_stream.precision(report_precision_c);
+    value_stream << value;
+    return value_stream.str();
+}
+
+// add ", <label><forked> instead of <unforked>" if they differ
+template <typename T>
+static void add_difference(string& line, const char* label, const T& forked, const T& unforked)
+{
+    string forked_text = format_value(forked), unforked_text = format_value(unforked);
+    if (forked_text != unforked_text)
+        line += string(", ") + label + forked_text + " instead of " + unforked_text;
+}
+
+Fork_baseline::Fork_baseline(shared_ptr<const Checkpoint> checkpoint_) :
+    checkpoint(checkpoint_), discarded_output(nullptr)
+{
+}
+
+// defined here, where a Model is complete
+Fork_baseline::~Fork_baseline()
+{
+}
+
+// The Fork that needs a later time than any before runs the baseline on to it, while
+// any others wait for it.
+map<string, Object_state> Fork_baseline::get_states(int time)
+{
+    lock_guard<mutex> lock(baseline_mutex);
+    if (!model) {
+        std::unique_ptr<Model> new_model(new Model(discarded_output));
+        new_model->load(*checkpoint);
+        model = std::move(new_model);
+        states.push_back(::get_states(*model));
+    }
+    while (model->get_time() < time) {
+        model->update();
+        states.push_back(::get_states(*model));
+    }
+    int start_time = model->get_time() - int(states.size()) + 1;
+    return states[std::max(time - start_time, 0)];
+}
+
+Fork::Fork(shared_ptr<Fork_baseline> baseline_, const vector<string>& orders_, int n_updates_) :
+    baseline(baseline_), orders(orders_), n_updates(n_updates_)
+{
+    runner = std::thread(&Fork::run, this);
+}
+
+Fork::~Fork()
+{
+    if (runner.joinable())
+        runner.join();
+}
+
+const vector<string>& Fork::get_report()
+{
+    if (runner.joinable())
+        runner.join();
+    return report;
+}
+
+// If the orders take time - by going - the unforked run is taken to the same time.
+void Fork::run()
+{
+    std::ostringstream forked_output;
+    Model forked(forked_output);
+    try {
+        forked.load(baseline->get_checkpoint());
+    } catch (Error& error) {
+        report.push_back(error.what());
+        return;
+    }
+    int start_time = forked.get_time();
+    {
+        std::istringstream no_input;
+        Controller controller(forked, no_input);
+        for (auto& order : orders) {
+            string::size_type message_start = forked_output.str().size();
+            if (!controller.run_command(order)) {
+                string message = forked_output.str().substr(message_start);
+                if (!message.empty() && message.back() == '\n')
+                    message.pop_back();
+                report.push_back("Order \"" + order + "\" not accepted: " + message);
+                return;
+            }
+        }
+    }
+    for (int i = 0; i < n_updates; i++)
+        forked.update();
+    map<string, Object_state> forked_states = get_states(forked);
+    map<string, Object_state> unforked_states;
+    try {
+        unforked_states = baseline->get_states(forked.get_time());
+    } catch (Error& error) {
+        report.push_back(error.what());
+        return;
+    }
+    report.push_back("From time " + std::to_string(start_time) + " to time " +
+        std::to_string(forked.get_time()));
+
+    for (auto& unforked_pair : unforked_states) {
+        if (!forked_states.count(unforked_pair.first))
+            report.push_back(unforked_pair.first + " is gone");
+    }
+    for (auto& forked_pair : forked_states) {
+        auto unforked_it = unforked_states.find(forked_pair.first);
+        if (unforked_it == unforked_states.end()) {
+            report.push_back(forked_pair.first + " is only in the fork");
+            continue;
+        }
+        const Object_state& state = forked_pair.second;
+        const Object_state& unforked_state = unforked_it->second;
+        string line;
+        add_difference(line, "at ", state.location, unforked_state.location);
+        add_difference(line, "fuel ", state.fuel, unforked_state.fuel);
+        if (state.has_motion && unforked_state.has_motion) {
+            add_difference(line, "course ", state.course, unforked_state.course);
+            add_difference(line, "speed ", state.speed, unforked_state.speed);
+        }
+        // without the leading ", "
+        if (!line.empty())
+            report.push_back(forked_pair.first + " " + line.substr(2));
+    }
+    if (report.size() == 1)
+        report.push_back("No differences");
+}
@@ -0,0 +1,90 @@
+#ifndef FORK_H
+#define FORK_H
+
+#include "View.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+A Fork answers "what if": it takes the state of the simulation, gives it some orders,
+and runs it forward a number of updates on a thread of its own, leaving the simulation
+itself alone. It compares the result with the same state run forward without the
+orders, as the simulation would go on if nothing were ordered, and reports how they
+differ: each object that is in only one of them, and each whose location, fuel, course,
+or speed differs. Any number of Forks can run at once.
+
+The state is taken as a Checkpoint, which is all the simulation pays for; the Models
+are restored from it on the Forks' threads. An order that is not accepted ends the Fork,
+which then reports the message the order got.
+
+The run without the orders is the same for every Fork started from the same state, so
+it is a Fork_baseline that they share. It is run forward only as far as some Fork needs,
+once, by whichever Fork needs it first, and keeps the state of every object at each
+time it reaches, since a Fork that finishes later may need an earlier time.
+*/
+
+class Checkpoint;
+class Model;
+
+class Fork_baseline {
+public:
+	explicit Fork_baseline(std::shared_ptr<const Checkpoint> checkpoint_);
+	~Fork_baseline();
+
+	const Checkpoint& get_checkpoint() const
+		{return *checkpoint;}
+
+	// the state of each object, by name, at the time, or at the start if the time is
+	// earlier; safe to call from several threads at once
+	// will throw the Errors thrown by loading the checkpoint
+	std::map<std::string, Object_state> get_states(int time);
+
+private:
+	std::shared_ptr<const Checkpoint> checkpoint;
+	std::mutex baseline_mutex;
+	std::ostream discarded_output;	// the baseline's messages are of no interest
+	std::unique_ptr<Model> model;	// loaded when first needed
+	std::vector<std::map<std::string, Object_state>> states;	// at each time from the start
+
+	// disallow copy/move construction or assignment
+	Fork_baseline(const Fork_baseline&) = delete;
+	Fork_baseline(Fork_baseline&&) = delete;
+	Fork_baseline& operator= (const Fork_baseline&) = delete;
+	Fork_baseline& operator= (Fork_baseline&&) = delete;
+};
+
+class Fork {
+public:
+	// start running the baseline's state with the orders, each a command as a user
+	// would type it, for the number of updates
+	Fork(std::shared_ptr<Fork_baseline> baseline_, const std::vector<std::string>& orders_,
+		int n_updates_);
+	// wait for the run to finish
+	~Fork();
+
+	// wait for the run to finish, and return the lines of its report, the first of
+	// which gives the times it ran from and to unless it ended early
+	const std::vector<std::string>& get_report();
+
+private:
+	std::shared_ptr<Fork_baseline> baseline;
+	std::vector<std::string> orders;
+	int n_updates;
+	std::vector<std::string> report;
+	std::thread runner;
+
+	void run();
+
+	// disallow copy/move construction or assignment
+	Fork(const Fork&) = delete;
+	Fork(Fork&&) = delete;
+	Fork& operator= (const Fork&) = delete;
+	Fork& operator= (Fork&&) = delete;
+};
+
+#endif
@@ -4,6 +4,7 @@ See Geometry.h for comments
 */
 
 #include "Geometry.h"
+#include "Fixed_format.h"
 
 #include <iostream>
 #include <cmath>
@@ -168,21 +169,21 @@ Polar_vector operator* (double d, const Polar_vector& pv)
 // output a Point as "(x, y)"
 ostream& operator<< (ostream& os, const Point& p)
 {
-	os << '(' << p.x << ", " << p.y << ')';
+	os << '(' << Fixed_value(p.x) << ", " << Fixed_value(p.y) << ')';
 	return os;
 }
 	
 // output a Cartesian_vector as "<x, y>"
 ostream& operator<< (ostream& os, const Cartesian_vector& cv)
 {
-	os << '<' << cv.delta_x << ", " << cv.delta_y << '>';
+	os << '<' << Fixed_value(cv.delta_x) << ", " << Fixed_value(cv.delta_y) << '>';
 	return os;
 }
 
 // output a Polar_vector as "P<r, theta>"
 ostream& operator<< (ostream& os, const Polar_vector& pv)
 {
-	os << "P<" << pv.r << ", " << pv.theta << '>';
+	os << "P<" << Fixed_value(pv.r) << ", " << Fixed_value(pv.theta) << '>';
 	return os;
 }
 
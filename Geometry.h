@@ -14,6 +14,11 @@ can be specified in radians, but radians can be converted to and from
 trigonometry degrees in which 0 degrees corresponds to (x > 0, y = 0), 
 and 90 degrees corresponds to (x = 0, y > 0).
 
+Scalar_t is the type used to store coordinates and other quantities that make up the
+state of simulated objects. It is double, unless the program is built with
+COMPACT_COORDINATES defined, in which case it is float, halving the space used by
+that state at the cost of precision. Computations are still done in double.
+
 Point is a set of (x, y) coordinates. 
 
 A Cartesian_vector is (delta_x, delta_y) - a displacement in Cartesian coordinates.
@@ -23,6 +28,12 @@ A Polar_vector is (r, theta) - a displacement in polar coordinates using radians
 Various overloaded operators support computations of positions and directions.
 */
 
+#ifdef COMPACT_COORDINATES
+typedef float Scalar_t;
+#else
+typedef double Scalar_t;
+#endif
+
 // angle units conversion functions
 double to_radians(double theta_d);
 double to_degrees(double theta_r);
@@ -37,8 +48,8 @@ struct Polar_vector;
 // A Point contains an (x, y) pair to represent coordinates
 struct Point
 {
-	double x;
-	double y;
+	Scalar_t x;
+	Scalar_t y;
 	
 	Point (double in_x = 0., double in_y = 0.) :
 		x(in_x), y(in_y)
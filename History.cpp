@@ -0,0 +1,412 @@
+#include "History.h"
+#include "Model.h"
+#include "Checkpoint.h"
+#include "Telemetry_format.h"
+#include "Utility.h"
+#include <cstdio>
+#include <fstream>
+
+using std::string;
+using std::to_string;
+using std::map;
+using std::vector;
+using std::size_t;
+
+// the parts of a delta that are present
+enum Delta_part_e {DELTA_MODEL = 1, DELTA_ISLANDS = 2};
+// how a changed ship is recorded: its whole entry, or the runs of bytes that differ
+enum Delta_entry_e {WHOLE_ENTRY, CHANGED_BYTES};
+// runs of changed bytes closer than this are recorded as one
+const size_t min_unchanged_run_c = 4;
+
+// a string of bytes, with its length
+static void append_bytes(string& data, const char* bytes, size_t size)
+{
+    append_varint(data, size);
+    data.append(bytes, size);
+}
+
+static void append_bytes(string& data, const string& bytes)
+{
+    append_bytes(data, bytes.data(), bytes.size());
+}
+
+// Reads what was appended to the data from the position.
+class Data_reader {
+public:
+    Data_reader(const string& data_, size_t position_ = 0) :
+        data(data_), position(position_) {}
+
+    unsigned long long get_varint()
+    {
+        unsigned long long value;
+        if (!read_varint(data, position, value))
+            throw Error("Could not read history file!");
+        return value;
+    }
+    const char* skip(size_t n)
+    {
+        if (n > data.size() - position)
+            throw Error("Could not read history file!");
+        const char* skipped = data.data() + position;
+        position += n;
+        return skipped;
+    }
+    string get_bytes()
+    {
+        size_t size = get_varint();
+        return string(skip(size), size);
+    }
+
+private:
+    const string& data;
+    size_t position;
+};
+
+// A ship's entry in the ships section of a Checkpoint is its type, name, and state.
+struct Ship_entry {
+    string name;
+    const char* bytes;
+    size_t size;
+};
+
+static vector<Ship_entry> get_ship_entries(const string& ships_section)
+{
+    vector<Ship_entry> entries;
+    Checkpoint_reader reader(ships_section.data(), ships_section.size());
+    for (unsigned n_ships = reader.get_unsigned(); n_ships > 0; n_ships--) {
+        const char* start = reader.skip(0);
+        reader.get_string();
+        string name = reader.get_string();
+        reader.get_string();
+        const char* end = reader.skip(0);
+        entries.push_back(Ship_entry{name, start, size_t(end - start)});
+    }
+    return entries;
+}
+
+static map<string, string> get_ships(const string& ships_section)
+{
+    map<string, string> ships;
+    for (auto& entry : get_ship_entries(ships_section))
+        ships.emplace_hint(ships.end(), entry.name, string(entry.bytes, entry.size));
+    return ships;
+}
+
+// record the runs of bytes in the entry that differ from the old one of the same size
+static void append_changed_bytes(string& delta, const string& old_entry, const char* entry)
+{
+    const char* old_bytes = old_entry.data();
+    size_t size = old_entry.size();
+    string runs;
+    size_t n_runs = 0, previous_end = 0, i = 0;
+    while (i < size) {
+        if (old_bytes[i] == entry[i]) {
+            i++;
+            continue;
+        }
+        // the run ends where enough bytes in a row are unchanged
+        size_t start = i, end = i + 1;
+        for (i = end; i < size && i - end < min_unchanged_run_c; i++) {
+            if (old_bytes[i] != entry[i])
+                end = i + 1;
+        }
+        append_varint(runs, start - previous_end);
+        append_bytes(runs, entry + start, end - start);
+        previous_end = end;
+        n_runs++;
+    }
+    append_varint(delta, n_runs);
+    delta += runs;
+}
+
+History::History(const string& file_prefix_, size_t memory_budget_, size_t disk_budget_) :
+    file_prefix(file_prefix_), memory_budget(memory_budget_), disk_budget(disk_budget_),
+    memory_used(0), disk_used(0), image_time(0)
+{
+}
+
+History::~History()
+{
+    for (auto& segment : segments) {
+        if (segment.in_file)
+            std::remove(get_filename(segment).c_str());
+    }
+}
+
+void History::set_budgets(size_t memory_budget_, size_t disk_budget_)
+{
+    memory_budget = memory_budget_;
+    disk_budget = disk_budget_;
+    keep_budgets();
+}
+
+// A keyframe is the Model's settings, islands, and ships sections. The image is brought
+// up to date as the delta is found, comparing the ships in order of name.
+void History::record(const Model& model)
+{
+    Checkpoint checkpoint;
+    model.save(checkpoint);
+    int time = model.get_time();
+    discard_from(time);
+    const string& model_section = checkpoint.get_section(MODEL_SECTION);
+    const string& islands_section = checkpoint.get_section(ISLANDS_SECTION);
+    const string& ships_section = checkpoint.get_section(SHIPS_SECTION);
+    if (segments.empty() || get_last_time() != image_time ||
+        segments.back().size - segments.back().records.front().second >=
+            segments.back().records.front().second) {
+        string keyframe;
+        append_bytes(keyframe, model_section);
+        append_bytes(keyframe, islands_section);
+        append_bytes(keyframe, ships_section);
+        image.model = model_section;
+        image.islands = islands_section;
+        image.ships = get_ships(ships_section);
+        image_time = time;
+        add_keyframe(time, std::move(keyframe));
+        return;
+    }
+
+    string delta(1, '\0');
+    if (model_section != image.model) {
+        delta[0] |= DELTA_MODEL;
+        append_bytes(delta, model_section);
+        image.model = model_section;
+    }
+    if (islands_section != image.islands) {
+        delta[0] |= DELTA_ISLANDS;
+        append_bytes(delta, islands_section);
+        image.islands = islands_section;
+    }
+    string removed, changed;
+    size_t n_removed = 0, n_changed = 0;
+    auto ship_it = image.ships.begin();
+    for (auto& entry : get_ship_entries(ships_section)) {
+        while (ship_it != image.ships.end() && ship_it->first < entry.name) {
+            append_bytes(removed, ship_it->first);
+            n_removed++;
+            ship_it = image.ships.erase(ship_it);
+        }
+        if (ship_it == image.ships.end() || ship_it->first != entry.name) {
+            append_bytes(changed, entry.name);
+            changed += char(WHOLE_ENTRY);
+            append_bytes(changed, entry.bytes, entry.size);
+            n_changed++;
+            image.ships.emplace_hint(ship_it, entry.name, string(entry.bytes, entry.size));
+            continue;
+        }
+        string& old_entry = ship_it->second;
+        if (old_entry.size() != entry.size) {
+            append_bytes(changed, entry.name);
+            changed += char(WHOLE_ENTRY);
+            append_bytes(changed, entry.bytes, entry.size);
+            n_changed++;
+            old_entry.assign(entry.bytes, entry.size);
+        }
+        else if (old_entry.compare(0, entry.size, entry.bytes, entry.size)) {
+            append_bytes(changed, entry.name);
+            changed += char(CHANGED_BYTES);
+            append_changed_bytes(changed, old_entry, entry.bytes);
+            n_changed++;
+            old_entry.assign(entry.bytes, entry.size);
+        }
+        ++ship_it;
+    }
+    while (ship_it != image.ships.end()) {
+        append_bytes(removed, ship_it->first);
+        n_removed++;
+        ship_it = image.ships.erase(ship_it);
+    }
+    append_varint(delta, n_removed);
+    delta += removed;
+    append_varint(delta, n_changed);
+    delta += changed;
+    image_time = time;
+    add_delta(time, delta);
+}
+
+// Nothing changes unless the Model is loaded.
+void History::seek(int time, Model& model)
+{
+    auto segment_it = segments.end();
+    while (segment_it != segments.begin() && (segment_it - 1)->time > time)
+        --segment_it;
+    if (segment_it == segments.begin())
+        throw Error("Time is not in the history!");
+    const Segment& segment = *(segment_it - 1);
+    size_t last = 0;
+    while (last + 1 < segment.records.size() && segment.records[last + 1].first <= time)
+        last++;
+    if (segment.records[last].first != time)
+        throw Error("Time is not in the history!");
+
+    string data = segment.in_file ? read_data(segment) : segment.data;
+    Image new_image;
+    Data_reader keyframe_reader(data);
+    new_image.model = keyframe_reader.get_bytes();
+    new_image.islands = keyframe_reader.get_bytes();
+    new_image.ships = get_ships(keyframe_reader.get_bytes());
+    for (size_t i = 1; i <= last; i++) {
+        Data_reader reader(data, segment.records[i].second);
+        unsigned parts = static_cast<unsigned char>(*reader.skip(1));
+        if (parts & DELTA_MODEL)
+            new_image.model = reader.get_bytes();
+        if (parts & DELTA_ISLANDS)
+            new_image.islands = reader.get_bytes();
+        for (auto n_removed = reader.get_varint(); n_removed > 0; n_removed--)
+            new_image.ships.erase(reader.get_bytes());
+        for (auto n_changed = reader.get_varint(); n_changed > 0; n_changed--) {
+            string& entry = new_image.ships[reader.get_bytes()];
+            if (*reader.skip(1) == WHOLE_ENTRY) {
+                entry = reader.get_bytes();
+                continue;
+            }
+            size_t position = 0;
+            for (auto n_runs = reader.get_varint(); n_runs > 0; n_runs--) {
+                position += reader.get_varint();
+                string bytes = reader.get_bytes();
+                if (position > entry.size() || bytes.size() > entry.size() - position)
+                    throw Error("Could not read history file!");
+                entry.replace(position, bytes.size(), bytes);
+                position += bytes.size();
+            }
+        }
+    }
+
+    Checkpoint checkpoint;
+    checkpoint.set_section(MODEL_SECTION, new_image.model);
+    checkpoint.set_section(ISLANDS_SECTION, new_image.islands);
+    Checkpoint_writer ships_writer;
+    ships_writer.put_unsigned(new_image.ships.size());
+    string ships_section = ships_writer.get_bytes();
+    for (auto& ship_pair : new_image.ships)
+        ships_section += ship_pair.second;
+    checkpoint.set_section(SHIPS_SECTION, ships_section);
+    model.load(checkpoint);
+    image = std::move(new_image);
+    image_time = time;
+}
+
+int History::get_last_time() const
+{
+    return segments.back().records.back().first;
+}
+
+// The segment that is then last is kept in memory, to be added to.
+void History::discard_from(int time)
+{
+    while (!segments.empty() && segments.back().time >= time)
+        forget_last();
+    if (segments.empty())
+        return;
+    Segment& segment = segments.back();
+    if (segment.in_file)
+        read_back(segment);
+    auto record_it = segment.records.begin() + 1;
+    while (record_it != segment.records.end() && record_it->first < time)
+        ++record_it;
+    if (record_it == segment.records.end())
+        return;
+    memory_used -= segment.size - record_it->second;
+    segment.size = record_it->second;
+    segment.data.resize(segment.size);
+    segment.records.erase(record_it, segment.records.end());
+}
+
+void History::add_keyframe(int time, string keyframe)
+{
+    size_t size = keyframe.size();
+    segments.push_back(Segment{time, {std::make_pair(time, size)}, std::move(keyframe), size, false});
+    memory_used += size;
+    keep_budgets();
+}
+
+void History::add_delta(int time, const string& delta)
+{
+    Segment& segment = segments.back();
+    segment.records.push_back(std::make_pair(time, segment.size));
+    segment.data += delta;
+    segment.size += delta.size();
+    memory_used += delta.size();
+    keep_budgets();
+}
+
+// The segments in files are always the oldest, and the last segment, being added to,
+// stays in memory. A segment that can't be written is forgotten, so that the budgets are
+// still kept.
+void History::keep_budgets()
+{
+    size_t n_in_file = 0;
+    while (n_in_file < segments.size() && segments[n_in_file].in_file)
+        n_in_file++;
+    while (memory_used > memory_budget && n_in_file + 1 < segments.size()) {
+        Segment& segment = segments[n_in_file];
+        while (disk_used + segment.size > disk_budget && n_in_file > 0) {
+            forget_first();
+            n_in_file--;
+        }
+        if (disk_used + segment.size > disk_budget) {
+            forget_first();
+            continue;
+        }
+        std::ofstream file(get_filename(segment), std::ios::binary | std::ios::trunc);
+        if (!file.write(segment.data.data(), segment.data.size()).flush()) {
+            file.close();
+            std::remove(get_filename(segment).c_str());
+            forget_first();
+            throw Error("Could not write history file!");
+        }
+        string().swap(segment.data);
+        segment.in_file = true;
+        memory_used -= segment.size;
+        disk_used += segment.size;
+        n_in_file++;
+    }
+}
+
+string History::get_filename(const Segment& segment) const
+{
+    return file_prefix + "." + to_string(segment.time);
+}
+
+string History::read_data(const Segment& segment) const
+{
+    std::ifstream file(get_filename(segment), std::ios::binary);
+    string data(segment.size, '\0');
+    if (!file.read(&data[0], data.size()))
+        throw Error("Could not read history file!");
+    return data;
+}
+
+void History::read_back(Segment& segment)
+{
+    segment.data = read_data(segment);
+    std::remove(get_filename(segment).c_str());
+    segment.in_file = false;
+    disk_used -= segment.size;
+    memory_used += segment.size;
+}
+
+void History::forget_first()
+{
+    Segment& segment = segments.front();
+    if (segment.in_file) {
+        std::remove(get_filename(segment).c_str());
+        disk_used -= segment.size;
+    }
+    else
+        memory_used -= segment.size;
+    segments.pop_front();
+}
+
+void History::forget_last()
+{
+    Segment& segment = segments.back();
+    if (segment.in_file) {
+        std::remove(get_filename(segment).c_str());
+        disk_used -= segment.size;
+    }
+    else
+        memory_used -= segment.size;
+    segments.pop_back();
+}
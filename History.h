@@ -0,0 +1,91 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+A History records the state of the Model at each update so that the simulation can be
+returned to any recorded time without running it again from the start.
+
+The state is recorded as the Model saves it in a Checkpoint: its settings, its islands,
+and an entry for each ship. The history is a sequence of segments, each a keyframe
+holding the whole state at one time followed by a delta for each later update, holding
+only what changed: the settings or islands if they changed, the ships that are gone, and
+the ships that are new or changed, each as the bytes of its entry that differ from before.
+Seeking loads the keyframe at or before the time and applies the deltas up to it.
+
+A segment ends, and the next update starts a new keyframe, once its deltas add up to as
+many bytes as its keyframe, so a seek never applies more than a keyframe's worth of deltas;
+the keyframes are far apart while little changes and close together while much does.
+When the segments take more memory than the memory budget, the oldest are written to
+files, named by the prefix and their keyframe's time, until those take more than the disk
+budget, and then the oldest are forgotten. The files are removed with the History.
+
+Recording a time at or before the last one recorded, as after a seek, discards everything
+recorded from that time on.
+*/
+
+class Model;
+
+class History {
+public:
+	// the budgets are in bytes
+	History(const std::string& file_prefix_, std::size_t memory_budget_, std::size_t disk_budget_);
+	~History();
+
+	void set_budgets(std::size_t memory_budget_, std::size_t disk_budget_);
+
+	// record the state of the Model at its current time
+	// will throw Error("Could not write history file!"), in which case the oldest
+	// history has been forgotten
+	void record(const Model& model);
+
+	// return the Model to its state at the time
+	// will throw Error("Time is not in the history!"), Error("Could not read history file!"),
+	// or the Errors thrown by Model::load
+	void seek(int time, Model& model);
+
+private:
+	// the state as saved in a Checkpoint, with the entry of each ship by name
+	struct Image {
+		std::string model;
+		std::string islands;
+		std::map<std::string, std::string> ships;
+	};
+	struct Segment {
+		int time;			// of the keyframe
+		// the time of the keyframe and then of each delta, and where each starts in the data
+		std::vector<std::pair<int, std::size_t>> records;
+		std::string data;	// the keyframe then the deltas, empty while in a file
+		std::size_t size;	// of the data
+		bool in_file;
+	};
+
+	std::string file_prefix;
+	std::size_t memory_budget;
+	std::size_t disk_budget;
+	std::deque<Segment> segments;
+	std::size_t memory_used;
+	std::size_t disk_used;
+	Image image;	// the state at image_time
+	int image_time;
+
+	int get_last_time() const;
+	void discard_from(int time);
+	void add_keyframe(int time, std::string keyframe);
+	void add_delta(int time, const std::string& delta);
+	// write the oldest segments to files, or forget them, until the budgets are kept
+	void keep_budgets();
+	std::string get_filename(const Segment& segment) const;
+	std::string read_data(const Segment& segment) const;
+	void read_back(Segment& segment);
+	void forget_first();
+	void forget_last();
+};
+
+#endif
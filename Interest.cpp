@@ -0,0 +1,108 @@
+#include "Interest.h"
+#include <algorithm>
+#include <cmath>
+
+using std::vector;
+using std::remove;
+
+// the size of the grid cells used to index regions
+const double interest_cell_size_c = 10.;
+// regions covering more cells than this are kept in the list of large regions
+const long max_region_cells_c = 64;
+// cells farther out than this are taken to be this far, well within the range of long
+const double max_cell_coordinate_c = 1e15;
+
+Interest_region Interest_region::box(Point lower_left_, Point upper_right_, unsigned attributes_)
+{
+    Interest_region region(attributes_);
+    region.shape = BOX;
+    region.lower_left = lower_left_;
+    region.upper_right = upper_right_;
+    return region;
+}
+
+Interest_region Interest_region::circle(Point center, double radius_, unsigned attributes_)
+{
+    Interest_region region(attributes_);
+    region.shape = CIRCLE;
+    region.lower_left = center;
+    region.radius = radius_;
+    return region;
+}
+
+bool Interest_region::contains(Point p) const
+{
+    switch (shape) {
+        case BOX:
+            return p.x >= lower_left.x && p.x < upper_right.x &&
+                p.y >= lower_left.y && p.y < upper_right.y;
+        case CIRCLE:
+            return cartesian_distance(lower_left, p) <= radius;
+        default:
+            return true;
+    }
+}
+
+void Interest_index::insert(View* view, const Interest_region& region)
+{
+    Cell_t first, last;
+    get_cell_range(region, first, last);
+    if (is_large(first, last)) {
+        large_regions.push_back(view);
+        return;
+    }
+    for (long x = first.first; x <= last.first; x++)
+        for (long y = first.second; y <= last.second; y++)
+            cells[Cell_t(x, y)].push_back(view);
+}
+
+void Interest_index::erase(View* view, const Interest_region& region)
+{
+    Cell_t first, last;
+    get_cell_range(region, first, last);
+    if (is_large(first, last)) {
+        large_regions.erase(remove(large_regions.begin(), large_regions.end(), view),
+                            large_regions.end());
+        return;
+    }
+    for (long x = first.first; x <= last.first; x++) {
+        for (long y = first.second; y <= last.second; y++) {
+            auto cell_it = cells.find(Cell_t(x, y));
+            if (cell_it == cells.end())
+                continue;
+            vector<View*>& views = cell_it->second;
+            views.erase(remove(views.begin(), views.end(), view), views.end());
+            if (views.empty())
+                cells.erase(cell_it);
+        }
+    }
+}
+
+// a coordinate in cells, clamped so that it converts to a whole number however far out it is
+static long get_cell_coordinate(double coordinate)
+{
+    return long(std::max(-max_cell_coordinate_c, std::min(max_cell_coordinate_c,
+                                                          floor(coordinate / interest_cell_size_c))));
+}
+
+Interest_index::Cell_t Interest_index::get_cell(Point p)
+{
+    return Cell_t(get_cell_coordinate(p.x), get_cell_coordinate(p.y));
+}
+
+void Interest_index::get_cell_range(const Interest_region& region, Cell_t& first, Cell_t& last)
+{
+    Point lower_left = region.lower_left, upper_right = region.upper_right;
+    if (region.shape == Interest_region::CIRCLE) {
+        lower_left = Point(region.lower_left.x - region.radius, region.lower_left.y - region.radius);
+        upper_right = Point(region.lower_left.x + region.radius, region.lower_left.y + region.radius);
+    }
+    first = get_cell(lower_left);
+    last = get_cell(upper_right);
+}
+
+bool Interest_index::is_large(const Cell_t& first, const Cell_t& last)
+{
+    double n_cells = double(last.first - first.first + 1) * double(last.second - first.second + 1);
+    return n_cells > max_region_cells_c;
+}
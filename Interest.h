@@ -0,0 +1,84 @@
+#ifndef INTEREST_H
+#define INTEREST_H
+
+#include "Geometry.h"
+#include <map>
+#include <utility>
+#include <vector>
+
+/*
+An Interest_region describes which notifications a View wants from the Model: the
+area whose objects it wants to hear about, and which of their attributes.
+A View attached with the default region hears about everything, everywhere.
+
+An Interest_index finds the Views whose regions may contain a Point. Regions are
+registered in the cells of a uniform grid that they overlap; regions too large for
+that to be worthwhile are kept in a separate list that is always searched.
+*/
+
+class View;
+
+// attribute mask bits
+enum View_attribute_e {LOCATION_ATTRIBUTE = 1, FUEL_ATTRIBUTE = 2, COURSE_ATTRIBUTE = 4,
+    SPEED_ATTRIBUTE = 8, TYPE_ATTRIBUTE = 16, ALL_ATTRIBUTES = 31};
+
+struct Interest_region {
+	enum Shape_e {EVERYWHERE, BOX, CIRCLE};
+	Shape_e shape;
+	Point lower_left;		// for a BOX, or the center of a CIRCLE
+	Point upper_right;		// for a BOX
+	double radius;			// for a CIRCLE
+	unsigned attributes;	// a mask of View_attribute_e bits
+
+	Interest_region(unsigned attributes_ = ALL_ATTRIBUTES) :
+		shape(EVERYWHERE), radius(0.), attributes(attributes_)
+		{}
+
+	static Interest_region box(Point lower_left_, Point upper_right_,
+		unsigned attributes_ = ALL_ATTRIBUTES);
+	static Interest_region circle(Point center, double radius_,
+		unsigned attributes_ = ALL_ATTRIBUTES);
+
+	bool is_everywhere() const
+		{return shape == EVERYWHERE;}
+	bool wants(View_attribute_e attribute) const
+		{return (attributes & attribute) != 0;}
+	bool contains(Point p) const;
+};
+
+class Interest_index {
+public:
+	// the region must not be EVERYWHERE
+	void insert(View* view, const Interest_region& region);
+	// the region must be the one the view was inserted with
+	void erase(View* view, const Interest_region& region);
+	// call f with each view whose region may contain the point, visiting the index's
+	// own lists so that nothing is copied
+	template <typename F>
+	void for_each_candidate(Point p, F f) const;
+
+private:
+	typedef std::pair<long, long> Cell_t;
+	std::map<Cell_t, std::vector<View*> > cells;
+	std::vector<View*> large_regions;
+
+	// the cell containing the point
+	static Cell_t get_cell(Point p);
+	// the range of cells covered by the region's bounding box
+	static void get_cell_range(const Interest_region& region, Cell_t& first, Cell_t& last);
+	static bool is_large(const Cell_t& first, const Cell_t& last);
+};
+
+template <typename F>
+void Interest_index::for_each_candidate(Point p, F f) const
+{
+	for (View* view : large_regions)
+		f(view);
+	auto cell_it = cells.find(get_cell(p));
+	if (cell_it != cells.end()) {
+		for (View* view : cell_it->second)
+			f(view);
+	}
+}
+
+#endif
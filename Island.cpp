@@ -1,23 +1,28 @@
 #include "Island.h"
+#include "Log.h"
+#include "Fixed_format.h"
 #include "Model.h"
+#include "Checkpoint.h"
 #include <iostream>
 
 using std::string;
-using std::cout; using std::endl;
+using std::endl;
 
 double Island::provide_fuel(double request)
 {
     double provided_amount = (request > fuel) ? fuel : request;
     fuel -= provided_amount;
-    cout << "Island " << get_name() << " supplied " << provided_amount
-        << " tons of fuel" << endl;
+    if (log_enabled(LOG_FUEL))
+        get_output() << "Island " << get_name() << " supplied " << Fixed_value(provided_amount)
+            << " tons of fuel" << endl;
     return provided_amount;
 }
 
 void Island::accept_fuel(double amount)
 {
     fuel += amount;
-    cout << "Island " << get_name() << " now has " << fuel << " tons" << endl;
+    if (log_enabled(LOG_FUEL))
+        get_output() << "Island " << get_name() << " now has " << Fixed_value(fuel) << " tons" << endl;
 }
 
 void Island::update()
@@ -26,13 +31,27 @@ void Island::update()
         accept_fuel(production_rate);
 }
 
-void Island::describe() const
+void Island::describe(std::ostream& os) const
 {
-    cout << "\nIsland " << get_name() << " at position " << position << endl;
-    cout << "Fuel available: " << fuel << " tons" << endl;
+    os << "\nIsland " << get_name() << " at position " << position << endl;
+    os << "Fuel available: " << Fixed_value(fuel) << " tons" << endl;
 }
 
 void Island::broadcast_current_state()
 {
-    Model::get_instance().notify_location(get_name(), position);
+    get_model().notify_location(get_name(), position);
+}
+
+void Island::save_state(Checkpoint_writer& writer) const
+{
+    writer.put_point(position);
+    writer.put_double(fuel);
+    writer.put_double(production_rate);
+}
+
+void Island::load_state(Checkpoint_reader& reader)
+{
+    position = reader.get_point();
+    fuel = reader.get_double();
+    production_rate = reader.get_double();
 }
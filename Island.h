@@ -13,9 +13,9 @@ accordingly.
 class Island : public Sim_object {
 public:
 	// initialize then output constructor message
-	Island (const std::string& name_, Point position_, double fuel_ = 0.,
+	Island (Model& model_, const std::string& name_, Point position_, double fuel_ = 0.,
             double production_rate_ = 0.) :
-        Sim_object(name_), position(position_), fuel(fuel_),
+        Sim_object(model_, name_), position(position_), fuel(fuel_),
         production_rate(production_rate_) {}
     
 	// Return whichever is less, the request or the amount left,
@@ -31,10 +31,13 @@ public:
 	void update() override;
 
 	// output information about the current state
-	void describe() const override;
+	void describe(std::ostream& os) const override;
 
 	// ask model to notify views of current state
 	void broadcast_current_state() override;
+	
+	void save_state(Checkpoint_writer& writer) const override;
+	void load_state(Checkpoint_reader& reader) override;
 
 private:
 	Point position;				// Location of this island
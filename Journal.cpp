@@ -0,0 +1,139 @@
+#include "Journal.h"
+#include "Utility.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+
+using std::string;
+using std::to_string;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+
+// how long the writer waits for more commands to commit with the first
+const std::chrono::milliseconds commit_delay_c(10);
+// how much of a line is read at once
+const int line_chunk_c = 256;
+
+Recording_buf::Recording_buf(std::FILE* source_) : source(source_)
+{
+    setg(&line[0], &line[0], &line[0]);
+    mark = gptr();
+}
+
+const string& Recording_buf::get_recorded()
+{
+    recorded.append(mark, gptr());
+    mark = gptr();
+    return recorded;
+}
+
+void Recording_buf::clear_recorded()
+{
+    recorded.clear();
+    mark = gptr();
+}
+
+// the characters are put back last first
+void Recording_buf::return_unread()
+{
+    for (char* unread = egptr(); unread > gptr(); unread--)
+        ungetc(static_cast<unsigned char>(unread[-1]), source);
+    setg(eback(), egptr(), egptr());
+    mark = gptr();
+}
+
+// A line is read at a time, which is no further than someone typing has finished.
+Recording_buf::int_type Recording_buf::underflow()
+{
+    recorded.append(mark, gptr());
+    std::size_t length = 0;
+    while (true) {
+        line.resize(length + line_chunk_c);
+        if (!fgets(&line[length], line_chunk_c, source))
+            break;
+        length += strlen(&line[length]);
+        if (line[length - 1] == '\n')
+            break;
+    }
+    line.resize(length);
+    setg(&line[0], &line[0], &line[0] + length);
+    mark = gptr();
+    return length ? traits_type::to_int_type(line[0]) : traits_type::eof();
+}
+
+Journal::Journal(std::istream& is_, std::FILE* source, const string& filename) :
+    is(is_), original_buf(is_.rdbuf()), recording_buf(source),
+    file(filename, std::ios::app), stopping(false)
+{
+    if (!file)
+        throw Error("Could not open journal file!");
+    is.rdbuf(&recording_buf);
+    writer = std::thread(&Journal::write_pending, this);
+}
+
+Journal::~Journal()
+{
+    recording_buf.return_unread();
+    is.rdbuf(original_buf);
+    {
+        lock_guard<mutex> lock(writer_mutex);
+        stopping = true;
+    }
+    writer_changed.notify_all();
+    writer.join();
+}
+
+void Journal::start_command()
+{
+    recording_buf.clear_recorded();
+}
+
+// The command is written on one line, without the whitespace around it.
+void Journal::accept_command(int time)
+{
+    const char* const whitespace = " \t\n\v\f\r";
+    const string& command = recording_buf.get_recorded();
+    string::size_type first = command.find_first_not_of(whitespace);
+    if (first == string::npos)
+        return;
+    string::size_type length = command.find_last_not_of(whitespace) + 1 - first;
+    bool was_empty;
+    {
+        lock_guard<mutex> lock(writer_mutex);
+        was_empty = pending.empty();
+        pending += to_string(time);
+        pending += ' ';
+        string::size_type command_start = pending.size();
+        pending.append(command, first, length);
+        for (string::size_type newline = pending.find('\n', command_start);
+             newline != string::npos; newline = pending.find('\n', newline))
+            pending[newline] = ' ';
+        pending += '\n';
+    }
+    recording_buf.clear_recorded();
+    // otherwise the writer already knows there is something to commit
+    if (was_empty)
+        writer_changed.notify_all();
+}
+
+// Once there is something to commit, the writer waits briefly for more before taking
+// everything pending at once, so that when commands come quickly a single write commits
+// many of them; commands accepted while it writes are committed together next.
+void Journal::write_pending()
+{
+    unique_lock<mutex> lock(writer_mutex);
+    while (true) {
+        writer_changed.wait(lock, [this] {return !pending.empty() || stopping;});
+        if (pending.empty())
+            return;
+        writer_changed.wait_for(lock, commit_delay_c, [this] {return stopping;});
+        string entries;
+        entries.swap(pending);
+        lock.unlock();
+        file.write(entries.data(), entries.size());
+        file.flush();
+        lock.lock();
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iosfwd>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+/*
+A Journal appends each command the Controller accepts to a file, so that after a crash
+the simulation can be recovered by loading the last checkpoint saved and replaying the
+commands that followed it. The file is text, a line for each command:
+	<time> <command as it was typed>
+where the time is the simulated time when the command was given.
+
+The commands are recorded by a Recording_buf that replaces the buffer of the input
+stream, reads its source a line at a time, and keeps a copy of every character read.
+Accepted commands are handed to a writer thread, which waits a few milliseconds for more
+and then writes everything waiting in one write and flush - a group commit - so the
+simulation never waits for the file. Commands accepted in the last few milliseconds
+before a crash may not be in the journal.
+*/
+
+class Recording_buf : public std::streambuf {
+public:
+	// read from the source a line at a time, so that nothing is read ahead of a command
+	explicit Recording_buf(std::FILE* source_);
+
+	// the characters read since the record was cleared
+	const std::string& get_recorded();
+	void clear_recorded();
+	// give the rest of the line back to the source
+	void return_unread();
+
+protected:
+	int_type underflow() override;
+
+private:
+	std::FILE* source;
+	std::string line;		// the get area
+	char* mark;				// the characters before this have been recorded
+	std::string recorded;
+};
+
+class Journal {
+public:
+	// record the commands read by the stream, appending them to the file, and start
+	// the writer thread; the stream must be reading the source through stdio, as cin
+	// does while it is synchronized with stdio
+	// will throw Error("Could not open journal file!")
+	Journal(std::istream& is_, std::FILE* source, const std::string& filename);
+	// commit everything accepted, stop the writer thread, and restore the stream's buffer
+	~Journal();
+
+	// a command is about to be read; forget anything read since the last one
+	void start_command();
+	// the command read since start_command was accepted at the time
+	void accept_command(int time);
+
+private:
+	std::istream& is;
+	std::streambuf* original_buf;
+	Recording_buf recording_buf;
+
+	// shared with the writer thread
+	std::ofstream file;
+	std::thread writer;
+	std::mutex writer_mutex;
+	std::condition_variable writer_changed;
+	std::string pending;	// accepted, not yet written
+	bool stopping;
+
+	void write_pending();
+
+	// disallow copy/move construction or assignment
+	Journal(const Journal&) = delete;
+	Journal(Journal&&) = delete;
+	Journal& operator= (const Journal&) = delete;
+	Journal& operator= (Journal&&) = delete;
+};
+
+#endif
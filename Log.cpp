@@ -0,0 +1,41 @@
+#include "Log.h"
+#include "Utility.h"
+#include <cstdlib>
+#include <sstream>
+
+using std::string;
+
+// the names of the categories, in the order of Log_category_e
+const char* const log_category_names_c[N_LOG_CATEGORIES] =
+    {"movement", "fuel", "cargo", "combat", "cruise"};
+const char* const log_environment_variable_c = "P5_LOG";
+
+Log_category_e get_log_category(const string& name)
+{
+    for (int i = 0; i < N_LOG_CATEGORIES; i++) {
+        if (name == log_category_names_c[i])
+            return Log_category_e(i);
+    }
+    throw Error("Unknown log category!");
+}
+
+void read_log_environment(unsigned& categories)
+{
+    const char* setting = std::getenv(log_environment_variable_c);
+    if (!setting)
+        return;
+    string names(setting);
+    if (names == "all") {
+        categories = all_log_categories_c;
+        return;
+    }
+    // check all of the names before changing anything
+    unsigned enabled = 0;
+    if (names != "none") {
+        std::istringstream name_stream(names);
+        string name;
+        while (getline(name_stream, name, ','))
+            enabled |= 1u << get_log_category(name);
+    }
+    categories = enabled;
+}
@@ -0,0 +1,33 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <string>
+
+/*
+The narration that objects print as they go about their business - moving, fueling,
+carrying cargo, fighting, and cruising - is divided into categories that can each be
+turned off. Each message is printed only if its category is enabled, which is checked
+before anything is formatted, so a suppressed message costs a single test.
+
+All categories are enabled by default. When the program starts, the P5_LOG environment
+variable, if set, gives the categories to enable as a comma-separated list of names,
+or "all" or "none"; the log command changes them while the program runs.
+Each Model has categories of its own, which its objects check, so that a log command
+run in one Model - an ensemble script, or a fork's orders - leaves the others alone.
+*/
+
+enum Log_category_e {LOG_MOVEMENT, LOG_FUEL, LOG_CARGO, LOG_COMBAT, LOG_CRUISE, N_LOG_CATEGORIES};
+
+// the categories are kept as a bit for each enabled one
+const unsigned all_log_categories_c = (1u << N_LOG_CATEGORIES) - 1;
+
+// the category with the name
+// will throw Error("Unknown log category!")
+Log_category_e get_log_category(const std::string& name);
+
+// set the categories to those given by the environment variable, if it is set,
+// leaving them alone otherwise
+// will throw Error("Unknown log category!")
+void read_log_environment(unsigned& categories);
+
+#endif
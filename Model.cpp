@@ -5,32 +5,38 @@
 #include "Ship_factory.h"
 #include "View.h"
 #include "Geometry.h"
+#include "Collision.h"
+#include "Checkpoint.h"
+#include <iostream>
 #include <algorithm>
 #include <functional>
 
 using std::string;
+using std::cout; using std::endl;
+using std::vector;
 using std::mem_fn; using std::bind;
-using std::placeholders::_1; using std::ref;
+using std::placeholders::_1;
 using std::map; using std::set;
 using std::shared_ptr;
 using std::for_each;
+using std::pair;
 
 
 Model& Model::get_instance()
 {
-    static Model the_model;
+    static Model the_model(cout);
     return the_model;
 }
 
-Model::Model() : time(0){
-	island_container["Exxon"] = shared_ptr<Island>(new Island("Exxon", Point(10, 10), 1000, 200));
-	island_container["Shell"] = shared_ptr<Island>(new Island("Shell", Point(0, 30), 1000, 200));
-	island_container["Bermuda"] = shared_ptr<Island>(new Island("Bermuda", Point(20, 20)));
-    island_container["Treasure_Island"] = shared_ptr<Island>(new Island("Treasure_Island", Point(50, 5), 100, 5));
+Model::Model(std::ostream& output_) : output(output_), log_categories(all_log_categories_c), time(0), collision_distance(0.), obstacle_radius(0.), geographic(false) {
+	island_container["Exxon"] = shared_ptr<Island>(new Island(*this, "Exxon", Point(10, 10), 1000, 200));
+	island_container["Shell"] = shared_ptr<Island>(new Island(*this, "Shell", Point(0, 30), 1000, 200));
+	island_container["Bermuda"] = shared_ptr<Island>(new Island(*this, "Bermuda", Point(20, 20)));
+    island_container["Treasure_Island"] = shared_ptr<Island>(new Island(*this, "Treasure_Island", Point(50, 5), 100, 5));
 	
-	ship_container["Ajax"] = create_ship("Ajax", "Cruiser", Point (15, 15));
-	ship_container["Xerxes"] = create_ship("Xerxes", "Cruiser", Point (25, 25));
-	ship_container["Valdez"] = create_ship("Valdez", "Tanker", Point (30, 30));
+	ship_container["Ajax"] = create_ship(*this, "Ajax", "Cruiser", Point (15, 15));
+	ship_container["Xerxes"] = create_ship(*this, "Xerxes", "Cruiser", Point (25, 25));
+	ship_container["Valdez"] = create_ship(*this, "Valdez", "Tanker", Point (30, 30));
     
     for (auto& island_pair : island_container)
         object_container[island_pair.first.substr(0, 2)] = island_pair.second;
@@ -53,6 +59,7 @@ void Model::add_island(shared_ptr<Island> new_island)
     island_container[new_island->get_name()] = new_island;
     object_container[new_island->get_name().substr(0, 2)] = new_island;
     new_island->broadcast_current_state();
+    update_obstacles();
 }
 
 shared_ptr<Island> Model::get_island_ptr(const std::string& name) const
@@ -85,64 +92,442 @@ shared_ptr<Ship> Model::get_ship_ptr(const std::string& name) const
 }
                               
 void Model::describe() const
-{    
-    for_each(object_container.begin(), object_container.end(),
-             bind(&Sim_object::describe,
-                  bind(& map<string, shared_ptr<Sim_object> >::value_type::second, _1)));
+{
+    vector<const Sim_object*> objects;
+    objects.reserve(object_container.size());
+    for (auto& object_pair : object_container)
+        objects.push_back(object_pair.second.get());
+    format_in_parallel(output, objects.size(), [&objects](std::ostream& os, size_t i) {
+        objects[i]->describe(os);
+    });
 }
 
 
 void Model::update()
 {
     ++time;
+    if (collision_distance > 0.)
+        start_collision_sweep();
+    if (current_field.is_loaded())
+        apply_currents();
     for_each(object_container.begin(), object_container.end(),
              bind(&Sim_object::update,
                   bind(& map<string, shared_ptr<Sim_object> >::value_type::second, _1)));
+    if (collision_distance > 0.)
+        detect_collisions();
+    for (auto& view_pair : view_container)
+        view_pair.second.view->update_tick(time);
 }
 
-void Model::attach(shared_ptr<View> view)
+void Model::set_collision_distance(double distance)
 {
-    view_container.insert(view);
-    for_each(object_container.begin(), object_container.end(),
-             bind(&Sim_object::broadcast_current_state,
-                  bind(& map<string, shared_ptr<Sim_object> >::value_type::second, _1)));
+    if (distance < 0.)
+        throw Error("Collision distance must not be negative!");
+    collision_distance = distance;
+}
+
+void Model::set_obstacle_radius(double radius)
+{
+    if (radius < 0.)
+        throw Error("Obstacle radius must not be negative!");
+    obstacle_radius = radius;
+    update_obstacles();
+}
+
+vector<Point> Model::plan_route(Point origin, Point destination)
+{
+    if (obstacle_radius == 0.)
+        return vector<Point>();
+    return route_planner.plan(origin, destination);
+}
+
+void Model::update_obstacles()
+{
+    vector<Point> centers;
+    for (auto& island_pair : island_container)
+        centers.push_back(island_pair.second->get_location());
+    route_planner.set_obstacles(centers, obstacle_radius);
+}
+
+void Model::load_currents(const string& filename)
+{
+    current_field.load(filename);
+}
+
+void Model::unload_currents()
+{
+    current_field.unload();
+}
+
+void Model::set_geographic_mode(double reference_latitude, double reference_longitude)
+{
+    if (reference_latitude <= -90. || reference_latitude >= 90.)
+        throw Error("Invalid reference latitude!");
+    geo_projection = Geo_projection(Geo_position(reference_latitude, reference_longitude));
+    geographic = true;
+}
+
+void Model::save(Checkpoint& checkpoint) const
+{
+    Checkpoint_writer model_writer;
+    model_writer.put_int(time);
+    model_writer.put_double(collision_distance);
+    model_writer.put_double(obstacle_radius);
+    model_writer.put_bool(geographic);
+    model_writer.put_double(geo_projection.reference.latitude);
+    model_writer.put_double(geo_projection.reference.longitude);
+    model_writer.put_string(current_field.get_filename());
+    checkpoint.set_section(MODEL_SECTION, model_writer.get_bytes());
+    
+    Checkpoint_writer islands_writer;
+    islands_writer.put_unsigned(island_container.size());
+    for (auto& island_pair : island_container) {
+        islands_writer.put_string(island_pair.first);
+        island_pair.second->save_state(islands_writer);
+    }
+    checkpoint.set_section(ISLANDS_SECTION, islands_writer.get_bytes());
+    
+    // each ship's state is written as a string, so that all of the ships can be
+    // created before any state, which may refer to other ships, is read
+    Checkpoint_writer ships_writer;
+    ships_writer.put_unsigned(ship_container.size());
+    for (auto& ship_pair : ship_container) {
+        ships_writer.put_string(ship_pair.second->get_type_name());
+        ships_writer.put_string(ship_pair.first);
+        Checkpoint_writer state_writer;
+        ship_pair.second->save_state(state_writer);
+        ships_writer.put_string(state_writer.get_bytes());
+    }
+    checkpoint.set_section(SHIPS_SECTION, ships_writer.get_bytes());
+}
+
+// Add a restored object to its container and the container of all objects, in which no
+// two objects may have the same first two characters. Objects are saved in order of name,
+// so they go at the end of their container.
+template <typename T>
+static void add_restored_object(map<string, shared_ptr<T> >& container,
+                                map<string, shared_ptr<Sim_object> >& objects,
+                                shared_ptr<T> object_ptr)
+{
+    const string& name = object_ptr->get_name();
+    size_t n_objects = objects.size();
+    if (name.length() >= 2)
+        objects.emplace_hint(objects.end(), name.substr(0, 2), object_ptr);
+    if (objects.size() == n_objects)
+        throw Error("Invalid checkpoint file!");
+    container.emplace_hint(container.end(), name, object_ptr);
+}
+
+void Model::load(const Checkpoint& checkpoint)
+{
+    const string& model_section = checkpoint.get_section(MODEL_SECTION);
+    Checkpoint_reader model_reader(model_section.data(), model_section.size());
+    int new_time = model_reader.get_int();
+    double new_collision_distance = model_reader.get_double();
+    double new_obstacle_radius = model_reader.get_double();
+    bool new_geographic = model_reader.get_bool();
+    double reference_latitude = model_reader.get_double();
+    double reference_longitude = model_reader.get_double();
+    string currents_filename = model_reader.get_string();
+    model_reader.check_end();
+    if (new_time < 0 || !(new_collision_distance >= 0.) || !(new_obstacle_radius >= 0.) ||
+        !(reference_latitude > -90. && reference_latitude < 90.))
+        throw Error("Invalid checkpoint file!");
+    
+    map<string, shared_ptr<Island> > new_islands;
+    map<string, shared_ptr<Ship> > new_ships;
+    map<string, shared_ptr<Sim_object> > new_objects;
+    const string& islands_section = checkpoint.get_section(ISLANDS_SECTION);
+    Checkpoint_reader islands_reader(islands_section.data(), islands_section.size());
+    for (unsigned n_islands = islands_reader.get_unsigned(); n_islands > 0; n_islands--) {
+        shared_ptr<Island> island_ptr(new Island(*this, islands_reader.get_string(), Point()));
+        island_ptr->load_state(islands_reader);
+        add_restored_object(new_islands, new_objects, island_ptr);
+    }
+    islands_reader.check_end();
+    
+    struct Saved_state {
+        Ship* ship_ptr;
+        const char* data;
+        size_t size;
+    };
+    vector<Saved_state> ship_states;
+    const string& ships_section = checkpoint.get_section(SHIPS_SECTION);
+    Checkpoint_reader ships_reader(ships_section.data(), ships_section.size());
+    for (unsigned n_ships = ships_reader.get_unsigned(); n_ships > 0; n_ships--) {
+        string type = ships_reader.get_string();
+        shared_ptr<Ship> ship_ptr = create_ship(*this, ships_reader.get_string(), type, Point());
+        add_restored_object(new_ships, new_objects, ship_ptr);
+        size_t state_size = ships_reader.get_unsigned();
+        ship_states.push_back(Saved_state{ship_ptr.get(), ships_reader.skip(state_size), state_size});
+    }
+    ships_reader.check_end();
+    for (auto& ship_state : ship_states) {
+        Checkpoint_reader state_reader(ship_state.data, ship_state.size, &new_islands, &new_ships);
+        ship_state.ship_ptr->load_state(state_reader);
+        state_reader.check_end();
+    }
+    
+    if (currents_filename.empty())
+        current_field.unload();
+    else
+        current_field.load(currents_filename);
+    time = new_time;
+    collision_distance = new_collision_distance;
+    obstacle_radius = new_obstacle_radius;
+    geographic = new_geographic;
+    geo_projection = Geo_projection(Geo_position(reference_latitude, reference_longitude));
+    island_container.swap(new_islands);
+    ship_container.swap(new_ships);
+    object_container.swap(new_objects);
+    update_obstacles();
+    // the Views start over with the new objects
+    object_interests.clear();
+    for (auto& view_pair : view_container) {
+        view_pair.second.inside.clear();
+        view_pair.first->clear();
+        send_snapshot(view_pair.second);
+    }
+}
+
+void Model::apply_currents()
+{
+    // sample in tile order so that ships near each other read the same part of the field
+    vector<pair<long, Ship*> > moving_ships;
+    for (auto& ship_pair : ship_container) {
+        if (ship_pair.second->is_moving())
+            moving_ships.push_back(pair<long, Ship*>(
+                current_field.get_tile(ship_pair.second->get_location()), ship_pair.second.get()));
+    }
+    sort(moving_ships.begin(), moving_ships.end());
+    vector<Point> locations;
+    locations.reserve(moving_ships.size());
+    for (auto& tile_ship : moving_ships)
+        locations.push_back(tile_ship.second->get_location());
+    vector<Cartesian_vector> drifts(moving_ships.size());
+    current_field.sample(locations.data(), drifts.data(), locations.size());
+    for (size_t i = 0; i < moving_ships.size(); i++)
+        moving_ships[i].second->set_current_drift(drifts[i]);
+}
+
+void Model::start_collision_sweep()
+{
+    swept_ships.clear();
+    swept_bodies.clear();
+    for (auto& ship_pair : ship_container) {
+        Point location = ship_pair.second->get_location();
+        swept_ships.push_back(ship_pair.second);
+        swept_bodies.push_back(Swept_body(&ship_pair.second->get_name(), location, location));
+    }
+}
+
+// The bodies are completed in place; ships sunk during the update are dropped.
+void Model::detect_collisions()
+{
+    size_t n_bodies = 0;
+    for (size_t i = 0; i < swept_ships.size(); i++) {
+        if (!swept_ships[i]->is_afloat())
+            continue;
+        swept_bodies[n_bodies] = swept_bodies[i];
+        swept_bodies[n_bodies++].end = swept_ships[i]->get_location();
+    }
+    swept_bodies.erase(swept_bodies.begin() + n_bodies, swept_bodies.end());
+    swept_ships.clear();
+    for (auto& island_pair : island_container) {
+        Point location = island_pair.second->get_location();
+        swept_bodies.push_back(Swept_body(&island_pair.first, location, location, true));
+    }
+    for (auto& contact : find_contacts(swept_bodies, collision_distance)) {
+        if (contact.is_island1)
+            output << *contact.name2 << " collides with island " << *contact.name1;
+        else if (contact.is_island2)
+            output << *contact.name1 << " collides with island " << *contact.name2;
+        else
+            output << *contact.name1 << " collides with " << *contact.name2;
+        output << " at " << contact.location << endl;
+    }
+}
+
+void Model::attach(shared_ptr<View> view, const Interest_region& region)
+{
+    View_subscription& subscription = view_container[view.get()];
+    subscription.view = view;
+    subscription.region = region;
+    index_subscription(subscription);
+    send_snapshot(subscription);
+}
+
+void Model::index_subscription(View_subscription& subscription)
+{
+    if (subscription.region.is_everywhere())
+        unbounded_subscriptions.push_back(&subscription);
+    else
+        interest_index.insert(subscription.view.get(), subscription.region);
+}
+
+void Model::unindex_subscription(View_subscription& subscription)
+{
+    if (subscription.region.is_everywhere())
+        unbounded_subscriptions.erase(std::remove(unbounded_subscriptions.begin(),
+            unbounded_subscriptions.end(), &subscription), unbounded_subscriptions.end());
+    else
+        interest_index.erase(subscription.view.get(), subscription.region);
+}
+
+void Model::send_snapshot(View_subscription& subscription)
+{
+    vector<Object_state> states;
+    states.reserve(object_container.size());
+    for (auto& object_pair : object_container) {
+        if (!subscription.region.contains(object_pair.second->get_location()))
+            continue;
+        states.push_back(Object_state());
+        object_pair.second->get_current_state(states.back());
+        if (!subscription.region.is_everywhere()) {
+            subscription.inside.insert(states.back().name);
+            object_interests[states.back().name].insert(subscription.view.get());
+        }
+    }
+    subscription.view->update_snapshot(states, subscription.region.attributes);
+}
+
+void Model::set_interest(shared_ptr<View> view, const Interest_region& region)
+{
+    View_subscription& subscription = view_container.at(view.get());
+    bool was_everywhere = subscription.region.is_everywhere();
+    unindex_subscription(subscription);
+    subscription.region = region;
+    index_subscription(subscription);
+    if (region.is_everywhere()) {
+        for (auto& name : subscription.inside)
+            object_interests[name].erase(view.get());
+        subscription.inside.clear();
+        // the view may be missing any of the objects now
+        send_snapshot(subscription);
+        return;
+    }
+    for (auto& object_pair : object_container) {
+        const string& name = object_pair.second->get_name();
+        Point location = object_pair.second->get_location();
+        // a view that heard about everything has every object
+        bool was_inside = was_everywhere || subscription.inside.count(name) > 0;
+        bool is_inside = region.contains(location);
+        if (is_inside && !subscription.inside.count(name)) {
+            subscription.inside.insert(name);
+            object_interests[name].insert(view.get());
+            if (!was_inside)
+                view->update_enter(name, location);
+        }
+        else if (!is_inside && was_inside) {
+            subscription.inside.erase(name);
+            object_interests[name].erase(view.get());
+            view->update_leave(name);
+        }
+    }
 }
 
 void Model::detach(shared_ptr<View> view)
 {
-    view_container.erase(view);
+    auto view_it = view_container.find(view.get());
+    if (view_it == view_container.end())
+        return;
+    View_subscription& subscription = view_it->second;
+    unindex_subscription(subscription);
+    for (auto& name : subscription.inside)
+        object_interests[name].erase(view.get());
+    view_container.erase(view_it);
+}
+
+template <typename F>
+void Model::for_each_interested_view(const string& name, View_attribute_e attribute, F f)
+{
+    for (View_subscription* subscription : unbounded_subscriptions) {
+        if (subscription->region.wants(attribute))
+            f(subscription->view.get());
+    }
+    auto interests_it = object_interests.find(name);
+    if (interests_it == object_interests.end())
+        return;
+    for (View* view : interests_it->second) {
+        if (view_container[view].region.wants(attribute))
+            f(view);
+    }
 }
 
+// Views with bounded regions that the object has left get a leave update; those whose
+// regions it is in get an enter update if it was not already there.
 void Model::notify_location(const std::string& name, Point location)
 {
-    for_each(view_container.begin(), view_container.end(),
-             bind(&View::update_location, _1, ref(name), ref(location)));
+    auto interests_it = object_interests.find(name);
+    if (interests_it != object_interests.end()) {
+        set<View*>& views = interests_it->second;
+        for (auto view_it = views.begin(); view_it != views.end(); ) {
+            View_subscription& subscription = view_container[*view_it];
+            if (subscription.region.contains(location))
+                ++view_it;
+            else {
+                subscription.inside.erase(name);
+                (*view_it)->update_leave(name);
+                view_it = views.erase(view_it);
+            }
+        }
+    }
+    interest_index.for_each_candidate(location, [&](View* view) {
+        View_subscription& subscription = view_container[view];
+        if (!subscription.region.contains(location))
+            return;
+        if (subscription.inside.insert(name).second) {
+            object_interests[name].insert(view);
+            view->update_enter(name, location);
+        }
+        else if (subscription.region.wants(LOCATION_ATTRIBUTE))
+            view->update_location(name, location);
+    });
+    for (View_subscription* subscription : unbounded_subscriptions) {
+        if (subscription->region.wants(LOCATION_ATTRIBUTE))
+            subscription->view->update_location(name, location);
+    }
 }
 
 void Model::notify_fuel(const std::string& name, double fuel)
 {
-    for_each(view_container.begin(), view_container.end(),
-             bind(&View::update_fuel, _1, ref(name), ref(fuel)));
+    for_each_interested_view(name, FUEL_ATTRIBUTE,
+                             [&](View* view){view->update_fuel(name, fuel);});
 }
 
 void Model::notify_course(const std::string& name, double course)
 {
-    for_each(view_container.begin(), view_container.end(),
-             bind(&View::update_course, _1, ref(name), ref(course)));
+    for_each_interested_view(name, COURSE_ATTRIBUTE,
+                             [&](View* view){view->update_course(name, course);});
 }
 
 
 void Model::notify_speed(const std::string& name, double speed)
 {
-    for_each(view_container.begin(), view_container.end(),
-             bind(&View::update_speed, _1, ref(name), ref(speed)));
+    for_each_interested_view(name, SPEED_ATTRIBUTE,
+                             [&](View* view){view->update_speed(name, speed);});
+}
+
+
+void Model::notify_type(const std::string& name, const std::string& type_name)
+{
+    for_each_interested_view(name, TYPE_ATTRIBUTE,
+                             [&](View* view){view->update_type(name, type_name);});
 }
 
 
 void Model::notify_gone(const std::string& name)
 {
-    for_each(view_container.begin(), view_container.end(),
-             bind(&View::update_remove, _1, ref(name)));
+    for (View_subscription* subscription : unbounded_subscriptions)
+        subscription->view->update_remove(name);
+    auto interests_it = object_interests.find(name);
+    if (interests_it == object_interests.end())
+        return;
+    for (View* view : interests_it->second) {
+        view_container[view].inside.erase(name);
+        view->update_remove(name);
+    }
+    object_interests.erase(interests_it);
 }
 
 
@@ -2,10 +2,18 @@
 #define MODEL_H
 
 #include "Utility.h"
+#include "Route_planner.h"
+#include "Current_field.h"
+#include "Navigation.h"
+#include "Interest.h"
+#include "Collision.h"
+#include "Log.h"
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 #include <memory>
+#include <iosfwd>
 
 /*
 Model is part of a simplified Model-View-Controller pattern.
@@ -19,6 +27,10 @@ Finally, it keeps the system's time.
 Controller tells Model what to do; Model in turn tells the objects what do, and
 when asked to do so by an object, tells all the Views whenever anything changes that might be relevant.
 Model also provides facilities for looking up objects given their name.
+
+Each Model is a separate world: its objects know the Model they belong to, and their
+messages go to its output, so that several can run at once on different threads.
+The program's own world, which the Controller runs, is get_instance().
 */
 
 class Model;
@@ -26,15 +38,32 @@ class Sim_object;
 class Ship;
 class View;
 class Island;
+class Checkpoint;
 struct Point;
 
 
 class Model {
 public:
+    // the world of the program, whose output is cout
     static Model& get_instance();
     
+    // create the initial objects, whose messages go to the output
+    explicit Model(std::ostream& output_);
+    
+	// where the messages of the Model and its objects go
+	std::ostream& get_output() const
+		{return output;}
+	
+	// which categories of the objects' messages are printed, all at first
+	bool log_enabled(Log_category_e category) const
+		{return (log_categories >> category) & 1u;}
+	unsigned get_log_categories() const
+		{return log_categories;}
+	void set_log_categories(unsigned log_categories_)
+		{log_categories = log_categories_;}
+	
 	// return the current time
-	int get_time() {return time;}
+	int get_time() const {return time;}
 
 	// is name already in use for either ship or island?
     // either the identical name, or identical in first two characters counts as in-use
@@ -53,16 +82,65 @@ public:
 	void add_ship(std::shared_ptr<Ship>);
 	// will throw Error("Ship not found!") if no ship of that name
 	std::shared_ptr<Ship> get_ship_ptr(const std::string& name) const;
+	int get_ship_count() const
+		{return int(ship_container.size());}
 	
 	// tell all objects to describe themselves
 	void describe() const;
-	// increment the time, and tell all objects to update themselves
+	// increment the time, and tell all objects to update themselves,
+	// then report any collisions that occurred during the update,
+	// and tell all Views that the update is finished
 	void update();	
+	
+	// Ships within this distance of each other or of an island during an update
+	// are reported as colliding; zero turns off collision detection (the default).
+	// will throw Error("Collision distance must not be negative!")
+	void set_collision_distance(double distance);
+	
+	// Islands are treated as circular obstacles of this radius when planning routes;
+	// zero turns off route planning (the default), so ships sail straight to their destination.
+	// will throw Error("Obstacle radius must not be negative!")
+	void set_obstacle_radius(double radius);
+	// return the waypoints a ship should pass through on its way to the destination,
+	// not including the destination; empty if it can sail straight there
+	std::vector<Point> plan_route(Point origin, Point destination);
+	
+	// Moving ships are carried along by the currents in the field in this file.
+	// may throw the Errors thrown by Current_field::load, in which case there are no currents
+	void load_currents(const std::string& filename);
+	// Remove the currents; no error if there are none
+	void unload_currents();
+	
+	// In geographic mode, Points are positions in a projection centered on a reference
+	// latitude and longitude, and ships sail great circles; otherwise they use plane sailing.
+	// will throw Error("Invalid reference latitude!") if not strictly between -90 and 90
+	void set_geographic_mode(double reference_latitude, double reference_longitude);
+	void set_plane_sailing_mode()
+		{geographic = false;}
+	// return the projection in geographic mode, nullptr for plane sailing
+	const Geo_projection* get_geo_projection() const
+		{return geographic ? &geo_projection : nullptr;}
+	   
+	/* Checkpoints */
+	// add the settings, the time, and all of the objects to the checkpoint
+	void save(Checkpoint& checkpoint) const;
+	// Replace the settings, the time, and all of the objects with those in the checkpoint.
+	// The objects are restored directly into the containers rather than added one by one,
+	// and then each attached View is cleared and sent a snapshot of them.
+	// will throw Error("Invalid checkpoint file!") or the Errors thrown by create_ship,
+	// leaving the Model unchanged; if the currents file can't be loaded, throws the Errors
+	// thrown by load_currents, leaving the Model unchanged except that there are no currents
+	void load(const Checkpoint& checkpoint);
 	   
 	/* View services */
-	// Attaching a View adds it to the container and causes it to be updated
-    // with all current objects'location (or other state information.
-	void attach(std::shared_ptr<View>);
+	// Attaching a View adds it to the container and sends it a snapshot of all
+    // current objects' state; Views already attached are not sent anything.
+    // The View is only told about objects in the region, and only the attributes it asks for;
+    // as objects move in and out of a bounded region, the View gets enter and leave updates.
+	void attach(std::shared_ptr<View>, const Interest_region& region = Interest_region());
+	// Change the region of an attached View, sending it enter and leave updates for
+    // the objects that are now in or out of it.
+	void set_interest(std::shared_ptr<View>, const Interest_region& region);
 	// Detach the View by discarding the supplied pointer from the container of Views
     // - no updates sent to it thereafter.
 	void detach(std::shared_ptr<View>);
@@ -79,6 +157,9 @@ public:
     // notify the views about an object's speed
     void notify_speed(const std::string& name, double speed);
     
+    // notify the views about a ship's type
+    void notify_type(const std::string& name, const std::string& type_name);
+    
 	// notify the views that an object is now gone
 	void notify_gone(const std::string& name);
     
@@ -87,14 +168,54 @@ public:
     std::set<std::shared_ptr<Island>, Island_comp> get_all_islands() const;
     
 private:
+	std::ostream& output;
+	unsigned log_categories;	// a bit for each enabled category
 	int time;		// the simulated time
+	double collision_distance;
+	double obstacle_radius;
+	Route_planner route_planner;
+	Current_field current_field;
+	bool geographic;
+	Geo_projection geo_projection;
     std::map<std::string, std::shared_ptr<Sim_object> > object_container;
     std::map<std::string, std::shared_ptr<Island> > island_container;
     std::map<std::string, std::shared_ptr<Ship> > ship_container;
-    std::set<std::shared_ptr<View> > view_container;
+    struct View_subscription {
+        std::shared_ptr<View> view;
+        Interest_region region;
+        std::set<std::string> inside;	// objects in a bounded region
+    };
+    std::map<View*, View_subscription> view_container;
+    // the subscriptions of views that hear about everything, in the order attached
+    std::vector<View_subscription*> unbounded_subscriptions;
+    // views with bounded regions, by location
+    Interest_index interest_index;
+    // for each object, the views with bounded regions that it is in
+    std::map<std::string, std::set<View*> > object_interests;
+    
+    // the ships and their locations at the start of the update, in the same order,
+    // kept between updates so that their space is reused
+    std::vector<std::shared_ptr<Ship>> swept_ships;
+    std::vector<Swept_body> swept_bodies;
     
-    // create the initial objects
-	Model();
+    // record each ship's location before the update as the start of its swept body
+    void start_collision_sweep();
+    // report contacts between ships and other ships or islands, given each
+    // ship's location before the update
+    void detect_collisions();
+    // give the route planner the current islands as obstacles
+    void update_obstacles();
+    // sample the currents for all moving ships and give them to the ships
+    void apply_currents();
+    // send the View a snapshot of the objects in its region, which are all
+    // recorded as being inside a bounded region
+    void send_snapshot(View_subscription& subscription);
+    // index the subscription by its region, or stop doing so
+    void index_subscription(View_subscription& subscription);
+    void unindex_subscription(View_subscription& subscription);
+    // call f with each View that wants the attribute of the named object
+    template <typename F>
+    void for_each_interested_view(const std::string& name, View_attribute_e attribute, F f);
     
 	// disallow copy/move construction or assignment
     Model(const Model &) = delete;
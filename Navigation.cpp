@@ -5,6 +5,7 @@ See Navigation.h for comments
 
 #include "Navigation.h"
 #include "Geometry.h"
+#include "Fixed_format.h"
 
 #include <iostream>
 #include <cmath>
@@ -134,7 +135,7 @@ ostream& operator<< (ostream& os, const Course_speed& cs)
 	if ((output_course + .005) >= 360.)
 		output_course = 0.00;
 	
-	os << "course " << output_course << " deg, speed " << cs.speed << " nm/hr";
+	os << "course " << Fixed_value(output_course) << " deg, speed " << Fixed_value(cs.speed) << " nm/hr";
 	return os;
 }
 
@@ -152,7 +153,7 @@ ostream& operator<< (ostream& os, const Compass_position& cp)
 	if ((output_bearing + .005) >= 360.)
 		output_bearing = 0.00;
 	
-	os << "bearing " << output_bearing << " deg, range " << cp.range << " nm";
+	os << "bearing " << Fixed_value(output_bearing) << " deg, range " << Fixed_value(cp.range) << " nm";
 	return os;
 }
 
@@ -170,7 +171,7 @@ ostream& operator<< (ostream& os, const Compass_vector& cv)
 	if ((output_direction + .005) >= 360.)
 		output_direction = 0.00;
 	
-	os << "direction " << output_direction << " deg, distance " << cv.distance << " nm";
+	os << "direction " << Fixed_value(output_direction) << " deg, distance " << Fixed_value(cv.distance) << " nm";
 	return os;
 }
 
@@ -221,3 +222,96 @@ Compass_position compute_CPA(Course_speed ownship_cs, Course_speed target_cs, Co
 
 
 
+
+// *** Great-circle navigation ***
+
+// nm in one degree of latitude, and the radius of the earth in nm that makes a
+// degree of great circle that long, so that the Geo_projection and great-circle
+// sailing agree on distances north and south
+const double nm_per_degree_latitude_c = 60.;
+const double earth_radius_c = nm_per_degree_latitude_c * 180. / (2. * atan2(1., 0.));
+
+double great_circle_distance(const Geo_position& p1, const Geo_position& p2)
+{
+	double lat1 = to_radians(p1.latitude);
+	double lat2 = to_radians(p2.latitude);
+	double sin_half_dlat = sin((lat2 - lat1) / 2.);
+	double sin_half_dlon = sin(to_radians(p2.longitude - p1.longitude) / 2.);
+	double a = sin_half_dlat * sin_half_dlat + cos(lat1) * cos(lat2) * sin_half_dlon * sin_half_dlon;
+	return 2. * earth_radius_c * atan2(sqrt(a), sqrt(1. - a));
+}
+
+double great_circle_bearing(const Geo_position& p1, const Geo_position& p2)
+{
+	double lat1 = to_radians(p1.latitude);
+	double lat2 = to_radians(p2.latitude);
+	double dlon = to_radians(p2.longitude - p1.longitude);
+	double y = sin(dlon) * cos(lat2);
+	double x = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(dlon);
+	double bearing = fmod(to_degrees(atan2(y, x)) + 360., 360.);
+	// never produce 360 instead of zero
+	return (bearing >= 360.) ? 0. : bearing;
+}
+
+Geo_position great_circle_destination(const Geo_position& p, double bearing, double distance)
+{
+	double lat1 = to_radians(p.latitude);
+	double theta = to_radians(bearing);
+	double delta = distance / earth_radius_c;
+	double lat2 = asin(sin(lat1) * cos(delta) + cos(lat1) * sin(delta) * cos(theta));
+	double dlon = atan2(sin(theta) * sin(delta) * cos(lat1), cos(delta) - sin(lat1) * sin(lat2));
+	// normalize longitude to [-180, 180)
+	double lon2 = fmod(p.longitude + to_degrees(dlon) + 540., 360.) - 180.;
+	return Geo_position(to_degrees(lat2), lon2);
+}
+
+// The center's terms of the haversine formula are worked out once for all the positions.
+void great_circle_range_query(const Geo_position& center, const Geo_position* positions,
+	size_t n, double range, vector<size_t>& result, vector<double>& ranges)
+{
+	result.clear();
+	ranges.clear();
+	double latitude_band = range / nm_per_degree_latitude_c;
+	double center_lat = to_radians(center.latitude);
+	double center_cos_lat = cos(center_lat);
+	for (size_t i = 0; i < n; i++) {
+		if (fabs(positions[i].latitude - center.latitude) > latitude_band)
+			continue;
+		double lat = to_radians(positions[i].latitude);
+		double sin_half_dlat = sin((lat - center_lat) / 2.);
+		double sin_half_dlon = sin(to_radians(positions[i].longitude - center.longitude) / 2.);
+		double a = sin_half_dlat * sin_half_dlat +
+			center_cos_lat * cos(lat) * sin_half_dlon * sin_half_dlon;
+		double distance = 2. * earth_radius_c * atan2(sqrt(a), sqrt(1. - a));
+		if (distance <= range) {
+			result.push_back(i);
+			ranges.push_back(distance);
+		}
+	}
+}
+
+Geo_projection::Geo_projection(const Geo_position& in_reference) :
+	reference(in_reference),
+	nm_per_degree_longitude(nm_per_degree_latitude_c * cos(to_radians(in_reference.latitude)))
+{}
+
+Point Geo_projection::to_point(const Geo_position& p) const
+{
+	// take the shorter way around in longitude
+	double dlon = fmod(p.longitude - reference.longitude + 540., 360.) - 180.;
+	return Point(dlon * nm_per_degree_longitude,
+		(p.latitude - reference.latitude) * nm_per_degree_latitude_c);
+}
+
+Geo_position Geo_projection::to_geo_position(const Point& p) const
+{
+	return Geo_position(reference.latitude + p.y / nm_per_degree_latitude_c,
+		reference.longitude + p.x / nm_per_degree_longitude);
+}
+
+// output a Geo_position as "lat deg, lon deg"
+ostream& operator<< (ostream& os, const Geo_position& gp)
+{
+	os << "lat " << Fixed_value(gp.latitude) << " deg, lon " << Fixed_value(gp.longitude) << " deg";
+	return os;
+}
@@ -17,9 +17,11 @@ For example, converting to/from (latitude,longitude) and Points entails
 taking the latitude into account to determining the difference in longitude and the 
 Point origin that is being assumed. In general, this entails assumptions about 
 the projection from  spherical earth coordinates to a plane, and thus does 
-not have a general solution. The lat/lon classes such as Geo_position and the related functions 
-for great_circle course calculations have been removed from this version of the Navigation module, 
-leaving only the Point class and functions for "plane sailing".
+not have a general solution. This module provides a Geo_position class for (latitude,longitude)
+positions and great-circle functions on a spherical earth, and a Geo_projection that
+converts between Geo_positions and Points with a simple equirectangular projection centered
+on a reference position, so that anything that works with Points can be used with
+Geo_positions near the reference.
 
 A Point is represented in (x, y) coordinates in an nautical mile (nm) grid 
 whose origin is (0, 0). Points can be compared with == and !=, 
@@ -60,7 +62,10 @@ the Compass_vector for its course and the time to get its new Point:
 
 */
 
+#include "Geometry.h"
 #include <iosfwd>
+#include <cstddef>
+#include <vector>
 
 // forward declarations
 struct Point;
@@ -68,6 +73,7 @@ struct Polar_vector;
 struct Course_speed;
 struct Compass_position;
 struct Compass_vector;
+struct Geo_position;
 
 /* Compass_position */
 // Compass_position describes a position in terms of bearing and range
@@ -93,8 +99,8 @@ struct Compass_position
 // A Course_speed can not be constructed from any other object.
 struct Course_speed
 {
-	double course;
-	double speed;	
+	Scalar_t course;
+	Scalar_t speed;	
 
 	Course_speed (double in_course = 0., double in_speed = 0.) : 
 		course(in_course), speed(in_speed)
@@ -148,5 +154,56 @@ std::ostream& operator<< (std::ostream& os, const Compass_vector& cv);
 // If the CPA is the current position, it is returned with the time being zero.
 Compass_position compute_CPA(Course_speed ownship_cs, Course_speed target_cs, Compass_position target_position_cp, double& time_to_CPA);
 
+// *** Great-circle navigation ***
+
+/* Geo_position */
+// Geo_position is a (latitude, longitude) in degrees; North latitudes and East longitudes
+// are positive.
+struct Geo_position
+{
+	double latitude;
+	double longitude;
+
+	Geo_position (double in_latitude = 0., double in_longitude = 0.) :
+		latitude(in_latitude), longitude(in_longitude)
+		{}
+};
+
+// great-circle distance in nm between two Geo_positions, using the haversine formula
+double great_circle_distance(const Geo_position& p1, const Geo_position& p2);
+
+// initial compass bearing of the great circle from p1 to p2
+double great_circle_bearing(const Geo_position& p1, const Geo_position& p2);
+
+// the Geo_position reached by sailing the great circle that starts out on the
+// compass bearing for the distance in nm
+Geo_position great_circle_destination(const Geo_position& p, double bearing, double distance);
+
+// Store into result the subscripts of the positions within range nm of center, and
+// into ranges their distances from it, in the same order. Positions whose latitude
+// alone puts them out of range are rejected without any trigonometry.
+void great_circle_range_query(const Geo_position& center, const Geo_position* positions,
+	std::size_t n, double range, std::vector<std::size_t>& result, std::vector<double>& ranges);
+
+/* Geo_projection */
+// Geo_projection converts between Geo_positions and Points in nm, with the reference
+// position at Point (0, 0), North along +y, and distances correct along the
+// reference latitude.
+struct Geo_projection
+{
+	Geo_position reference;
+
+	Geo_projection (const Geo_position& in_reference = Geo_position());
+
+	Point to_point(const Geo_position& p) const;
+	Geo_position to_geo_position(const Point& p) const;
+
+private:
+	double nm_per_degree_longitude;
+};
+
+// output a Geo_position as "lat deg, lon deg"
+std::ostream& operator<< (std::ostream& os, const Geo_position& gp);
+
 
 #endif
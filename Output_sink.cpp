@@ -0,0 +1,117 @@
+#include "Output_sink.h"
+#include <iostream>
+
+using std::string;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+
+// the size of the sink's buffer
+const std::size_t sink_buffer_size_c = 1 << 16;
+
+Output_sink::Output_sink(std::ostream& os_) :
+    os(os_), target(os_.rdbuf()), buffer(sink_buffer_size_c), policy(FLUSH_EACH_LINE),
+    pending_flush(false), stopping(false)
+{
+    setp(buffer.data(), buffer.data() + buffer.size());
+    os.rdbuf(this);
+}
+
+Output_sink::~Output_sink()
+{
+    set_writer_thread(false);
+    flush_all();
+    os.rdbuf(target);
+}
+
+void Output_sink::set_writer_thread(bool on)
+{
+    if (on == writer.joinable())
+        return;
+    if (on) {
+        stopping = false;
+        writer = std::thread(&Output_sink::write_pending, this);
+        return;
+    }
+    hand_off(false);
+    {
+        lock_guard<mutex> lock(writer_mutex);
+        stopping = true;
+    }
+    writer_changed.notify_all();
+    writer.join();
+}
+
+void Output_sink::end_of_command()
+{
+    if (policy != FLUSH_EACH_TICK)
+        flush_all();
+}
+
+void Output_sink::end_of_tick()
+{
+    flush_all();
+}
+
+void Output_sink::flush_all()
+{
+    hand_off(true);
+}
+
+Output_sink::int_type Output_sink::overflow(int_type c)
+{
+    hand_off(false);
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int Output_sink::sync()
+{
+    if (policy == FLUSH_EACH_LINE)
+        flush_all();
+    return 0;
+}
+
+void Output_sink::hand_off(bool flush)
+{
+    std::size_t n = pptr() - pbase();
+    if (!writer.joinable()) {
+        if (n)
+            target->sputn(pbase(), n);
+        if (flush)
+            target->pubsync();
+    }
+    else if (n || flush) {
+        {
+            lock_guard<mutex> lock(writer_mutex);
+            pending.append(pbase(), n);
+            pending_flush = pending_flush || flush;
+        }
+        writer_changed.notify_all();
+    }
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+// The writer takes everything pending at once, so text handed off while it writes
+// is written next, in order.
+void Output_sink::write_pending()
+{
+    unique_lock<mutex> lock(writer_mutex);
+    while (true) {
+        writer_changed.wait(lock, [this] {return !pending.empty() || pending_flush || stopping;});
+        if (pending.empty() && !pending_flush)
+            return;
+        string text;
+        text.swap(pending);
+        bool flush = pending_flush;
+        pending_flush = false;
+        lock.unlock();
+        target->sputn(text.data(), text.size());
+        if (flush)
+            target->pubsync();
+        lock.lock();
+    }
+}
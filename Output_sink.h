@@ -0,0 +1,79 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <condition_variable>
+#include <iosfwd>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+An Output_sink is a large buffer that replaces the buffer of a stream (cout), so that
+every module's output goes through it. Flushing the stream - as std::endl does after
+every line - flushes the sink only if its policy is to flush each line; otherwise the
+sink is flushed at the end of each command or of each update of the simulation, and
+whenever the buffer fills. Output to a file or pipe then takes a few large writes
+instead of one for every line.
+
+Optionally, a writer thread does the writing, so the simulation does not wait for it.
+Either way, output is written in the order it was produced.
+
+The default is to flush each line with no writer thread, which behaves just like the
+stream's own buffer.
+*/
+
+class Output_sink : public std::streambuf {
+public:
+	enum Flush_policy_e {FLUSH_EACH_LINE, FLUSH_EACH_COMMAND, FLUSH_EACH_TICK};
+
+	// replace the stream's buffer with the sink, which writes to the stream's buffer
+	explicit Output_sink(std::ostream& os_);
+	// write everything out, stop any writer thread, and restore the stream's buffer
+	~Output_sink();
+
+	void set_flush_policy(Flush_policy_e policy_)
+		{policy = policy_;}
+	Flush_policy_e get_flush_policy() const
+		{return policy;}
+	// start or stop the writer thread; stopping waits for it to finish writing
+	void set_writer_thread(bool on);
+
+	// a command has been finished, or an update of the simulation;
+	// flush if that is the policy
+	void end_of_command();
+	void end_of_tick();
+	// write out and flush everything
+	void flush_all();
+
+protected:
+	int_type overflow(int_type c) override;
+	int sync() override;
+
+private:
+	std::ostream& os;
+	std::streambuf* target;
+	std::vector<char> buffer;	// the put area
+	Flush_policy_e policy;
+
+	// shared with the writer thread
+	std::thread writer;
+	std::mutex writer_mutex;
+	std::condition_variable writer_changed;
+	std::string pending;	// handed to the writer, not yet written
+	bool pending_flush;		// the target is to be flushed after pending is written
+	bool stopping;
+
+	// pass the put area on to be written, and flush the target afterwards if asked
+	void hand_off(bool flush);
+	void write_pending();
+
+	// disallow copy/move construction or assignment
+	Output_sink(const Output_sink&) = delete;
+	Output_sink(Output_sink&&) = delete;
+	Output_sink& operator= (const Output_sink&) = delete;
+	Output_sink& operator= (Output_sink&&) = delete;
+};
+
+#endif
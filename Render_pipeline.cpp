@@ -0,0 +1,176 @@
+#include "Render_pipeline.h"
+#include "View.h"
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+using std::string;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::ostringstream;
+
+// the size of the put area of the ordered buffer
+const std::size_t output_buffer_size_c = 4096;
+// at most this many snapshots wait to be drawn, so the pipeline is triple buffered
+const std::size_t max_pending_snapshots_c = 3;
+
+Ordered_output_buf::Ordered_output_buf(std::streambuf* target_) :
+    target(target_), buffer(output_buffer_size_c)
+{
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+Ordered_output_buf::~Ordered_output_buf()
+{
+    sync();
+}
+
+Ordered_output_buf::Segment_id Ordered_output_buf::reserve()
+{
+    flush_buffer();
+    lock_guard<mutex> lock(segments_mutex);
+    Segment segment = {string(), false, nullptr};
+    segments.push_back(segment);
+    return std::prev(segments.end());
+}
+
+void Ordered_output_buf::complete(Segment_id id, const string& text)
+{
+    lock_guard<mutex> lock(segments_mutex);
+    id->text = text;
+    id->ready = true;
+    write_ready();
+}
+
+void Ordered_output_buf::call_in_order(std::function<void()> action)
+{
+    flush_buffer();
+    lock_guard<mutex> lock(segments_mutex);
+    if (segments.empty()) {
+        action();
+        return;
+    }
+    Segment segment = {string(), true, action};
+    segments.push_back(segment);
+}
+
+Ordered_output_buf::int_type Ordered_output_buf::overflow(int_type c)
+{
+    flush_buffer();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int Ordered_output_buf::sync()
+{
+    flush_buffer();
+    lock_guard<mutex> lock(segments_mutex);
+    // held back text is flushed when it is finally written
+    return segments.empty() ? target->pubsync() : 0;
+}
+
+void Ordered_output_buf::flush_buffer()
+{
+    std::size_t n = pptr() - pbase();
+    if (n == 0)
+        return;
+    {
+        lock_guard<mutex> lock(segments_mutex);
+        append(pbase(), n);
+    }
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+void Ordered_output_buf::write_ready()
+{
+    bool written = false;
+    while (!segments.empty() && segments.front().ready) {
+        target->sputn(segments.front().text.data(), segments.front().text.size());
+        if (segments.front().action)
+            segments.front().action();
+        segments.pop_front();
+        written = true;
+    }
+    if (written)
+        target->pubsync();
+}
+
+void Ordered_output_buf::append(const char* text, std::size_t n)
+{
+    if (segments.empty())
+        target->sputn(text, n);
+    // text after an action must not be written before it is called
+    else if (segments.back().ready && !segments.back().action)
+        segments.back().text.append(text, n);
+    else {
+        Segment segment = {string(text, n), true, nullptr};
+        segments.push_back(segment);
+    }
+}
+
+
+Render_pipeline::Render_pipeline(std::ostream& os_) :
+    os(os_), original_buf(os_.rdbuf()), output_buf(original_buf), stopping(false)
+{
+    os.rdbuf(&output_buf);
+    render_thread = std::thread(&Render_pipeline::render, this);
+}
+
+Render_pipeline::~Render_pipeline()
+{
+    drain();
+    {
+        lock_guard<mutex> lock(jobs_mutex);
+        stopping = true;
+    }
+    jobs_changed.notify_all();
+    render_thread.join();
+    os.flush();
+    os.rdbuf(original_buf);
+}
+
+void Render_pipeline::submit(View& view)
+{
+    std::shared_ptr<View> snapshot = view.snapshot();
+    if (!snapshot) {
+        view.draw_on(os);
+        return;
+    }
+    unique_lock<mutex> lock(jobs_mutex);
+    jobs_changed.wait(lock, [this] {return jobs.size() < max_pending_snapshots_c;});
+    Job job;
+    job.snapshot = snapshot;
+    job.text.reset(new ostringstream);
+    job.text->copyfmt(os);
+    job.segment = output_buf.reserve();
+    jobs.push_back(std::move(job));
+    jobs_changed.notify_all();
+}
+
+void Render_pipeline::drain()
+{
+    unique_lock<mutex> lock(jobs_mutex);
+    jobs_changed.wait(lock, [this] {return jobs.empty();});
+}
+
+// The front job stays in the queue while it is drawn, so that it counts as pending.
+void Render_pipeline::render()
+{
+    unique_lock<mutex> lock(jobs_mutex);
+    while (true) {
+        jobs_changed.wait(lock, [this] {return !jobs.empty() || stopping;});
+        if (jobs.empty())
+            return;
+        Job& job = jobs.front();
+        lock.unlock();
+        job.snapshot->draw_on(*job.text);
+        output_buf.complete(job.segment, job.text->str());
+        lock.lock();
+        jobs.pop_front();
+        jobs_changed.notify_all();
+    }
+}
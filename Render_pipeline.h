@@ -0,0 +1,119 @@
+#ifndef RENDER_PIPELINE_H
+#define RENDER_PIPELINE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+A Render_pipeline draws Views on a background thread, so the simulation can go on to
+the next command while the last show is formatted and written.
+
+A View is submitted by taking a snapshot of it, which the render thread draws into a
+string; the View itself goes on being updated. Up to max_pending_snapshots_c snapshots
+may be waiting; submitting another waits for the oldest to be written.
+
+While the pipeline exists, its Ordered_output_buf replaces the buffer of the stream it
+was created with. Text written to the stream while snapshots are waiting is held back
+until they have been written, so the output is the same, in the same order, as if each
+View had been drawn when it was submitted.
+*/
+
+class View;
+
+class Ordered_output_buf : public std::streambuf {
+public:
+	// writes go to the target, which must outlive this buffer
+	explicit Ordered_output_buf(std::streambuf* target_);
+	~Ordered_output_buf();
+
+	struct Segment {
+		std::string text;
+		bool ready;		// the text is complete and may be written
+		std::function<void()> action;	// if any, called after the text is written
+	};
+	typedef std::list<Segment>::iterator Segment_id;
+
+	// hold a place in the output, after everything written so far, for text that
+	// will be supplied later
+	Segment_id reserve();
+	// supply the text for a place, then write out everything no longer waiting;
+	// may be called from any thread
+	void complete(Segment_id id, const std::string& text);
+	// call the action once everything written so far has been passed on to the target,
+	// which may be later and on another thread
+	void call_in_order(std::function<void()> action);
+
+protected:
+	int_type overflow(int_type c) override;
+	int sync() override;
+
+private:
+	std::streambuf* target;
+	std::vector<char> buffer;	// the put area, used only by the writing thread
+	std::mutex segments_mutex;
+	std::list<Segment> segments;	// held back, oldest first
+
+	// pass the put area on to the target, or hold it back if anything is waiting
+	void flush_buffer();
+	// write out the leading ready segments; the mutex must be locked
+	void write_ready();
+	void append(const char* text, std::size_t n);
+
+	// disallow copy/move construction or assignment
+	Ordered_output_buf(const Ordered_output_buf&) = delete;
+	Ordered_output_buf(Ordered_output_buf&&) = delete;
+	Ordered_output_buf& operator= (const Ordered_output_buf&) = delete;
+	Ordered_output_buf& operator= (Ordered_output_buf&&) = delete;
+};
+
+class Render_pipeline {
+public:
+	// install the ordered buffer into the stream and start the render thread
+	explicit Render_pipeline(std::ostream& os_);
+	// write everything submitted, then stop the thread and restore the stream's buffer
+	~Render_pipeline();
+
+	// draw the view later from a snapshot, or now if it can't be snapshotted
+	void submit(View& view);
+	// wait until everything submitted has been written
+	void drain();
+	// call the action once everything written to the stream so far has been passed on
+	// to the stream's original buffer; only such actions may use that buffer directly
+	void call_in_order(std::function<void()> action)
+		{output_buf.call_in_order(action);}
+
+private:
+	struct Job {
+		std::shared_ptr<View> snapshot;
+		std::unique_ptr<std::ostringstream> text;	// formatted like the stream
+		Ordered_output_buf::Segment_id segment;
+	};
+
+	std::ostream& os;
+	std::streambuf* original_buf;
+	Ordered_output_buf output_buf;
+	std::mutex jobs_mutex;
+	std::condition_variable jobs_changed;
+	std::deque<Job> jobs;	// the front job is being drawn
+	bool stopping;
+	std::thread render_thread;
+
+	void render();
+
+	// disallow copy/move construction or assignment
+	Render_pipeline(const Render_pipeline&) = delete;
+	Render_pipeline(Render_pipeline&&) = delete;
+	Render_pipeline& operator= (const Render_pipeline&) = delete;
+	Render_pipeline& operator= (Render_pipeline&&) = delete;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "Route_planner.h"
+#include <cmath>
+#include <limits>
+
+using std::vector;
+using std::map;
+using std::numeric_limits;
+
+// the size of the cells used to share routes between nearby origins
+const double route_cell_size_c = 1.0;
+// when this many routes are cached, the cache is discarded and started over
+const size_t route_cache_limit_c = 10000;
+// the number of points placed around each obstacle
+const int ring_points_c = 8;
+// the ring is placed far enough out that the lines between its points clear the obstacle
+const double ring_factor_c = 1.1;
+
+const double two_pi = 4. * atan2(1., 0.);
+
+bool Route_planner::Route_key::operator< (const Route_key& rhs) const
+{
+    if (origin_x != rhs.origin_x)
+        return origin_x < rhs.origin_x;
+    if (origin_y != rhs.origin_y)
+        return origin_y < rhs.origin_y;
+    if (destination_x != rhs.destination_x)
+        return destination_x < rhs.destination_x;
+    return destination_y < rhs.destination_y;
+}
+
+void Route_planner::set_obstacles(const vector<Point>& centers_, double radius_)
+{
+    centers = centers_;
+    radius = radius_;
+    route_cache.clear();
+}
+
+const vector<Point>& Route_planner::plan(Point origin, Point destination)
+{
+    Route_key key;
+    key.origin_x = long(floor(origin.x / route_cell_size_c));
+    key.origin_y = long(floor(origin.y / route_cell_size_c));
+    key.destination_x = destination.x;
+    key.destination_y = destination.y;
+    auto cache_it = route_cache.find(key);
+    if (cache_it != route_cache.end())
+        return cache_it->second;
+    if (route_cache.size() >= route_cache_limit_c)
+        route_cache.clear();
+    return route_cache[key] = find_route(origin, destination);
+}
+
+vector<Point> Route_planner::find_route(Point origin, Point destination) const
+{
+    vector<bool> ignored(centers.size());
+    for (size_t i = 0; i < centers.size(); i++)
+        ignored[i] = cartesian_distance(centers[i], origin) <= radius ||
+            cartesian_distance(centers[i], destination) <= radius;
+    if (radius <= 0. || !is_blocked(origin, destination, ignored))
+        return vector<Point>();
+
+    // node 0 is the origin, node 1 the destination, the rest are ring points
+    vector<Point> nodes = {origin, destination};
+    for (size_t i = 0; i < centers.size(); i++) {
+        if (ignored[i])
+            continue;
+        for (int k = 0; k < ring_points_c; k++) {
+            Point node = centers[i] + Polar_vector(radius * ring_factor_c, two_pi * k / ring_points_c);
+            bool inside_obstacle = false;
+            for (size_t j = 0; j < centers.size() && !inside_obstacle; j++)
+                inside_obstacle = !ignored[j] && cartesian_distance(centers[j], node) < radius;
+            if (!inside_obstacle)
+                nodes.push_back(node);
+        }
+    }
+
+    // Dijkstra's algorithm over the visibility graph, whose edges are found as needed
+    const double infinity = numeric_limits<double>::infinity();
+    vector<double> distance(nodes.size(), infinity);
+    vector<int> previous(nodes.size(), -1);
+    vector<bool> done(nodes.size(), false);
+    distance[0] = 0.;
+    while (true) {
+        int current = -1;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (!done[i] && distance[i] < infinity && (current < 0 || distance[i] < distance[current]))
+                current = int(i);
+        }
+        if (current < 0)
+            return vector<Point>();
+        if (current == 1)
+            break;
+        done[current] = true;
+        for (size_t i = 1; i < nodes.size(); i++) {
+            if (done[i])
+                continue;
+            double new_distance = distance[current] + cartesian_distance(nodes[current], nodes[i]);
+            if (new_distance < distance[i] && !is_blocked(nodes[current], nodes[i], ignored)) {
+                distance[i] = new_distance;
+                previous[i] = current;
+            }
+        }
+    }
+    vector<Point> route;
+    for (int node = previous[1]; node > 0; node = previous[node])
+        route.insert(route.begin(), nodes[node]);
+    return route;
+}
+
+bool Route_planner::is_blocked(Point p1, Point p2, const vector<bool>& ignored) const
+{
+    Cartesian_vector segment = p2 - p1;
+    double length_squared = segment.delta_x * segment.delta_x + segment.delta_y * segment.delta_y;
+    for (size_t i = 0; i < centers.size(); i++) {
+        if (ignored[i])
+            continue;
+        Cartesian_vector to_center = centers[i] - p1;
+        // parameter along the segment of the point closest to the center
+        double t = 0.;
+        if (length_squared > 0.)
+            t = (to_center.delta_x * segment.delta_x + to_center.delta_y * segment.delta_y)
+                / length_squared;
+        t = (t < 0.) ? 0. : (t > 1.) ? 1. : t;
+        if (cartesian_distance(p1 + segment * t, centers[i]) < radius)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,52 @@
+#ifndef ROUTE_PLANNER_H
+#define ROUTE_PLANNER_H
+
+#include "Geometry.h"
+#include <map>
+#include <vector>
+
+/*
+A Route_planner finds a route between two points that avoids a set of circular
+obstacles, all with the same radius. It builds a visibility graph whose nodes are the
+origin, the destination, and a ring of points placed just outside each obstacle;
+two nodes are connected if the straight line between them does not pass through any
+obstacle. The shortest path through the graph gives the route.
+
+An obstacle that contains the origin or the destination is ignored, so that a ship
+can leave or arrive at an island that is itself an obstacle.
+
+Routes are cached by the cell containing the origin and the exact destination, so
+ships that start near each other and go to the same place share one computation.
+Changing the obstacles discards the cache.
+*/
+
+class Route_planner {
+public:
+	Route_planner() : radius(0.) {}
+
+	// set the obstacles and their radius, and discard any cached routes
+	void set_obstacles(const std::vector<Point>& centers_, double radius_);
+
+	// Return the waypoints to pass through on the way from origin to destination,
+	// not including the destination itself. The result is empty if the straight line
+	// is clear, or if no route could be found.
+	const std::vector<Point>& plan(Point origin, Point destination);
+
+private:
+	struct Route_key {
+		long origin_x, origin_y;	// origin cell subscripts
+		double destination_x, destination_y;
+		bool operator< (const Route_key& rhs) const;
+	};
+	std::vector<Point> centers;
+	double radius;
+	std::map<Route_key, std::vector<Point> > route_cache;
+
+	// compute the route without using the cache
+	std::vector<Point> find_route(Point origin, Point destination) const;
+	// true if the segment from p1 to p2 passes through an obstacle other than
+	// those marked as ignored
+	bool is_blocked(Point p1, Point p2, const std::vector<bool>& ignored) const;
+};
+
+#endif
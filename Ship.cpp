@@ -1,13 +1,19 @@
 #include "Ship.h"
+#include "Log.h"
+#include "Fixed_format.h"
+#include "Checkpoint.h"
 #include "Island.h"
 #include "Utility.h"
 #include "Model.h"
+#include "View.h"
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 
 using std::string;
-using std::cout; using std::endl;
+using std::endl;
 using std::shared_ptr;
+using std::min;
 
 
 /*
@@ -45,29 +51,29 @@ bool Ship::can_dock(shared_ptr<Island> island_ptr) const
 }
 
 
-void Ship::describe() const
+void Ship::describe(std::ostream& os) const
 {
-    cout << get_name() << " at " << get_location();
+    os << get_name() << " at " << get_location();
     if (is_afloat())
-        cout << ", fuel: " << fuel << " tons, resistance: " << resistance << endl;
+        os << ", fuel: " << Fixed_value(fuel) << " tons, resistance: " << resistance << endl;
     switch (ship_state) {
         case SUNK:
-            cout << " sunk" << endl;
+            os << " sunk" << endl;
             break;
         case MOVING_TO_POSITION:
-            cout << "Moving to " << destination << " on " << track.get_course_speed() << endl;
+            os << "Moving to " << destination << " on " << track.get_course_speed() << endl;
             break;
         case STOPPED:
-            cout << "Stopped" << endl;
+            os << "Stopped" << endl;
             break;
         case DEAD_IN_THE_WATER:
-            cout << "Dead in the water" << endl;
+            os << "Dead in the water" << endl;
             break;
         case MOVING_ON_COURSE:
-            cout << "Moving on " << track.get_course_speed() << endl;
+            os << "Moving on " << track.get_course_speed() << endl;
             break;
         case DOCKED:
-            cout << "Docked at " << docked_at->get_name() << endl;
+            os << "Docked at " << docked_at->get_name() << endl;
             break;
         default:
             assert(false);
@@ -79,18 +85,63 @@ void Ship::describe() const
 
 void Ship::broadcast_current_state()
 {
-    Model::get_instance().notify_location(get_name(), get_location());
-    Model::get_instance().notify_fuel(get_name(), fuel);
+    get_model().notify_location(get_name(), get_location());
+    get_model().notify_type(get_name(), get_type_name());
+    get_model().notify_fuel(get_name(), fuel);
     notify_course_and_speed();
 }
 
+void Ship::get_current_state(Object_state& state) const
+{
+    Sim_object::get_current_state(state);
+    state.has_motion = true;
+    state.type_name = get_type_name();
+    state.fuel = fuel;
+    state.course = track.get_course();
+    state.speed = track.get_speed();
+}
+
+// The current drift applies only during an update, so there is none to save.
+void Ship::save_state(Checkpoint_writer& writer) const
+{
+    writer.put_double(fuel);
+    writer.put_int(resistance);
+    writer.put_unsigned(ship_state);
+    writer.put_point(destination);
+    writer.put_unsigned(waypoints.size());
+    for (auto& waypoint : waypoints)
+        writer.put_point(waypoint);
+    writer.put_point(track.get_position());
+    writer.put_double(track.get_course());
+    writer.put_double(track.get_speed());
+    writer.put_object(docked_at.get());
+}
+
+void Ship::load_state(Checkpoint_reader& reader)
+{
+    fuel = reader.get_double();
+    resistance = reader.get_int();
+    ship_state = Ship_state_e(reader.get_enum(SUNK + 1));
+    destination = reader.get_point();
+    waypoints.clear();
+    for (unsigned n_waypoints = reader.get_unsigned(); n_waypoints > 0; n_waypoints--)
+        waypoints.push_back(reader.get_point());
+    track.set_position(reader.get_point());
+    double course = reader.get_double();
+    track.set_course_speed(Course_speed(course, reader.get_double()));
+    docked_at = reader.get_island_ptr();
+}
+
 void Ship::set_destination_position_and_speed(Point destination_position, double speed)
 {
     destination = destination_position;
-    check_and_set_course_speed(Compass_vector(get_location(), destination_position).direction, speed);
+    waypoints = get_model().plan_route(get_location(), destination_position);
+    std::reverse(waypoints.begin(), waypoints.end());
+    check_and_set_course_speed(course_to(get_leg_destination()), speed);
     notify_course_and_speed();
-    cout << get_name() << " will sail on " << track.get_course_speed()
-        << " to " << destination << endl;
+    if (log_enabled(LOG_MOVEMENT))
+        get_output() << get_name() << " will sail on " << track.get_course_speed()
+            << " to " << destination << endl;
     ship_state = MOVING_TO_POSITION;
 }
 
@@ -98,7 +149,8 @@ void Ship::set_course_and_speed(double course, double speed)
 {
     check_and_set_course_speed(course, speed);
     notify_course_and_speed();
-    cout << get_name() << " will sail on " << track.get_course_speed() << endl;
+    if (log_enabled(LOG_MOVEMENT))
+        get_output() << get_name() << " will sail on " << track.get_course_speed() << endl;
     ship_state = MOVING_ON_COURSE;
 }
 
@@ -111,10 +163,33 @@ void Ship::check_and_set_course_speed(double course, double speed)
     track.set_course_speed(Course_speed(course, speed));
 }
 
+Point Ship::get_leg_destination() const
+{
+    return waypoints.empty() ? destination : waypoints.back();
+}
+
+double Ship::distance_to(Point p) const
+{
+    const Geo_projection* projection = get_model().get_geo_projection();
+    if (!projection)
+        return cartesian_distance(get_location(), p);
+    return great_circle_distance(projection->to_geo_position(get_location()),
+                                 projection->to_geo_position(p));
+}
+
+double Ship::course_to(Point p) const
+{
+    const Geo_projection* projection = get_model().get_geo_projection();
+    if (!projection)
+        return Compass_vector(get_location(), p).direction;
+    return great_circle_bearing(projection->to_geo_position(get_location()),
+                                projection->to_geo_position(p));
+}
+
 void Ship::notify_course_and_speed()
 {
-    Model::get_instance().notify_speed(get_name(), track.get_speed());
-    Model::get_instance().notify_course(get_name(), track.get_course());
+    get_model().notify_speed(get_name(), track.get_speed());
+    get_model().notify_course(get_name(), track.get_course());
 }
 
 void Ship::stop()
@@ -122,8 +197,9 @@ void Ship::stop()
     if (!can_move())
         throw Error("Ship cannot move!");
     track.set_speed(0.);
-    Model::get_instance().notify_speed(get_name(), track.get_speed());
-    cout << get_name() << " stopping at " << track.get_position() << endl;
+    get_model().notify_speed(get_name(), track.get_speed());
+    if (log_enabled(LOG_MOVEMENT))
+        get_output() << get_name() << " stopping at " << track.get_position() << endl;
     ship_state = STOPPED;
 }
 
@@ -132,8 +208,9 @@ void Ship::dock(shared_ptr<Island> island_ptr)
     if (!can_dock(island_ptr))
         throw Error("Can't dock!");
     track.set_position(island_ptr->get_location());
-    Model::get_instance().notify_location(get_name(), get_location());
-    cout << get_name() << " docked at " << island_ptr->get_name() << endl;
+    get_model().notify_location(get_name(), get_location());
+    if (log_enabled(LOG_MOVEMENT))
+        get_output() << get_name() << " docked at " << island_ptr->get_name() << endl;
     docked_at = island_ptr;
     ship_state = DOCKED;
 }
@@ -147,9 +224,10 @@ void Ship::refuel()
         fuel = fuel_capacity;
     else {
         fuel += docked_at->provide_fuel(fuel_needed);
-        cout << get_name() <<  " now has " << fuel << " tons of fuel" << endl;
+        if (log_enabled(LOG_FUEL))
+            get_output() << get_name() <<  " now has " << Fixed_value(fuel) << " tons of fuel" << endl;
     }
-    Model::get_instance().notify_fuel(get_name(), fuel);
+    get_model().notify_fuel(get_name(), fuel);
 }
 
 void Ship::set_load_destination(shared_ptr<Island>)
@@ -175,14 +253,16 @@ void Ship::stop_attack()
 void Ship::receive_hit(int hit_force, shared_ptr<Ship> attacker_ptr)
 {
     resistance -= hit_force;
-    cout << get_name() << " hit with " << hit_force << ", resistance now "
-        << resistance << endl;
+    if (log_enabled(LOG_COMBAT))
+        get_output() << get_name() << " hit with " << hit_force << ", resistance now "
+            << resistance << endl;
     if (resistance < 0.) {
-        cout << get_name() << " sunk" << endl;
+        if (log_enabled(LOG_COMBAT))
+            get_output() << get_name() << " sunk" << endl;
         ship_state = SUNK;
         track.set_speed(0.);
-        Model::get_instance().notify_gone(get_name());
-        Model::get_instance().remove_ship(shared_from_this());
+        get_model().notify_gone(get_name());
+        get_model().remove_ship(shared_from_this());
     }
 }
 
@@ -197,22 +277,27 @@ void Ship::update()
         case MOVING_TO_POSITION:
         case MOVING_ON_COURSE:
             calculate_movement();
-            cout << get_name() << " now at " << get_location() << endl;
-            Model::get_instance().notify_location(get_name(), get_location());
-            Model::get_instance().notify_fuel(get_name(), fuel);
-            Model::get_instance().notify_speed(get_name(), track.get_speed());
+            if (log_enabled(LOG_MOVEMENT))
+                get_output() << get_name() << " now at " << get_location() << endl;
+            get_model().notify_location(get_name(), get_location());
+            get_model().notify_fuel(get_name(), fuel);
+            get_model().notify_speed(get_name(), track.get_speed());
             break;
         case STOPPED:
-            cout << get_name() << " stopped at " << get_location() << endl;
+            if (log_enabled(LOG_MOVEMENT))
+                get_output() << get_name() << " stopped at " << get_location() << endl;
             break;
         case DOCKED:
-            cout <<  get_name() << " docked at " << docked_at->get_name() << endl;
+            if (log_enabled(LOG_MOVEMENT))
+                get_output() <<  get_name() << " docked at " << docked_at->get_name() << endl;
             break;
         case DEAD_IN_THE_WATER:
-            cout <<  get_name() << " dead in the water at " << get_location() << endl;
+            if (log_enabled(LOG_MOVEMENT))
+                get_output() <<  get_name() << " dead in the water at " << get_location() << endl;
             break;
         case SUNK:
-            cout << get_name() << " sunk" << endl;
+            if (log_enabled(LOG_MOVEMENT))
+                get_output() << get_name() << " sunk" << endl;
             break;
         default:
             assert(false);
@@ -242,8 +327,27 @@ void Ship:: calculate_movement()
 	// Compute values for how much we need to move, and how much we can, and how long we can,
 	// given the fuel state, then decide what to do.
 	double time = 1.0;	// "full step" time
-	// get the distance to destination
-	double destination_distance = cartesian_distance(get_location(), destination);
+	// the current applies to this update only
+	Cartesian_vector drift = current_drift;
+	current_drift = Cartesian_vector();
+	// pass any waypoints that can be reached in this step, turning towards the next one,
+	// and leave the rest of the step for the code below
+	while (ship_state == MOVING_TO_POSITION && !waypoints.empty()) {
+		double waypoint_distance = distance_to(waypoints.back());
+		double waypoint_distance_possible = min<double>(track.get_speed() * time, fuel / fuel_consumption);
+		if (waypoint_distance > waypoint_distance_possible)
+			break;
+		track.set_position(waypoints.back());
+		waypoints.pop_back();
+		if (waypoint_distance > 0.) {
+			fuel -= waypoint_distance * fuel_consumption;
+			time -= waypoint_distance / track.get_speed();
+		}
+		track.set_course(course_to(get_leg_destination()));
+		get_model().notify_course(get_name(), track.get_course());
+	}
+	// get the distance to the end of the current leg; any waypoint left is out of reach
+	double destination_distance = distance_to(get_leg_destination());
 	// get full step distance we can move on this time step
 	double full_distance = track.get_speed() * time;
 	// get fuel required for full step distance
@@ -259,8 +363,8 @@ void Ship:: calculate_movement()
 		time_possible = (distance_possible / full_distance) * time;
 		}
 	
-	// are we are moving to a destination, and is the destination within the distance possible?
-	if(ship_state == MOVING_TO_POSITION && destination_distance <= distance_possible) {
+	// are we are moving to a destination, on its last leg, and is the destination within the distance possible?
+	if(ship_state == MOVING_TO_POSITION && waypoints.empty() && destination_distance <= distance_possible) {
 		// yes, make our new position the destination
 		track.set_position(destination);
 		// we travel the destination distance, using that much fuel
@@ -272,7 +376,19 @@ void Ship:: calculate_movement()
 	else {
 		// go as far as we can, stay in the same movement state
 		// simply move for the amount of time possible
-		track.update_position(time_possible);
+		// the current carries the ship along without using any fuel
+		const Geo_projection* projection = get_model().get_geo_projection();
+		if (!projection)
+			track.update_position(time_possible, drift);
+		else
+			track.update_position_great_circle(time_possible, *projection, drift);
+		// the course along a great circle changes as the ship sails it, and a current
+		// sets the ship off the line to its destination in either mode
+		bool drifted = drift.delta_x != 0. || drift.delta_y != 0.;
+		if (ship_state == MOVING_TO_POSITION && (projection || drifted)) {
+			track.set_course(course_to(get_leg_destination()));
+			get_model().notify_course(get_name(), track.get_course());
+		}
 		// have we used up our fuel?
 		if(full_fuel_required >= fuel) {
 			fuel = 0.0;
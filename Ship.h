@@ -6,6 +6,7 @@
 #include "Sim_object.h"
 #include "Track_base.h"
 #include <memory>
+#include <vector>
 
 /***** Ship Class *****/
 /* A Ship has a name, initial position, amount of fuel, and parameters 
@@ -27,9 +28,9 @@ class Island;
 class Ship : public Sim_object, public std::enable_shared_from_this<Ship> {
 public:
 	// initialize, then output constructor message
-	Ship(const std::string& name_, Point position_, double fuel_capacity_,
+	Ship(Model& model_, const std::string& name_, Point position_, double fuel_capacity_,
         double maximum_speed_, double fuel_consumption_, int resistance_) :
-        Sim_object(name_), fuel_capacity(fuel_capacity_), fuel(fuel_capacity_),
+        Sim_object(model_, name_), fuel_capacity(fuel_capacity_), fuel(fuel_capacity_),
         maximum_speed(maximum_speed_), fuel_consumption(fuel_consumption_),
         resistance(resistance_), ship_state(STOPPED), track(position_) {}
 		
@@ -60,10 +61,19 @@ public:
 	// Update the state of the Ship
 	void update() override;
 	// output a description of current state to cout
-	void describe() const override;
+	void describe(std::ostream& os) const override;
 	
 	void broadcast_current_state() override;
 	
+	// add fuel, course, and speed to the current state
+	void get_current_state(Object_state& state) const override;
+	
+	// the type of ship, as given to create_ship
+	virtual const char* get_type_name() const = 0;
+	
+	void save_state(Checkpoint_writer& writer) const override;
+	void load_state(Checkpoint_reader& reader) override;
+	
 	/*** Command functions ***/
 	// Start moving to a destination position at a speed
      // may throw Error("Ship cannot move!")
@@ -97,6 +107,9 @@ public:
 	// interactions with other objects
 	// receive a hit from an attacker
 	virtual void receive_hit(int hit_force, std::shared_ptr<Ship> attacker_ptr);
+	// set the current that will carry the ship along during its next update, if it is moving
+	void set_current_drift(Cartesian_vector drift)
+        {current_drift = drift;}
 		
 protected:
 	// future projects may need additional protected members
@@ -109,19 +122,27 @@ protected:
 private:
     enum Ship_state_e {MOVING_TO_POSITION, STOPPED, DEAD_IN_THE_WATER,
         MOVING_ON_COURSE, DOCKED, SUNK};
-    double fuel_capacity;
-	double fuel;						// Current amount of fuel
-    double maximum_speed;
-	double fuel_consumption;			// tons/nm required
+    Scalar_t fuel_capacity;
+	Scalar_t fuel;						// Current amount of fuel
+    Scalar_t maximum_speed;
+	Scalar_t fuel_consumption;			// tons/nm required
     int resistance;
     Ship_state_e ship_state;
     Point destination;					// Current destination if any
+    std::vector<Point> waypoints;		// remaining waypoints to destination, last one is next
     Track_base track;
+    Cartesian_vector current_drift;		// applies to the next update only
     std::shared_ptr<Island>docked_at;
 
 	// Updates position, fuel, and movement_state, assuming 1 time unit (1 hr)
 	void calculate_movement();
     void check_and_set_course_speed(double course, double speed);
+    // the point the ship is currently steering for - the next waypoint or the destination
+    Point get_leg_destination() const;
+    // distance and course from the current location to the point, along a great circle
+    // if the Model is in geographic mode
+    double distance_to(Point p) const;
+    double course_to(Point p) const;
     void notify_course_and_speed();
 
 	// disallow copy/move, construction or assignment
@@ -7,14 +7,14 @@
 
 using std::shared_ptr;
 
-shared_ptr<Ship> create_ship(const std::string& name, const std::string& type, Point initial_position)
+shared_ptr<Ship> create_ship(Model& model, const std::string& name, const std::string& type, Point initial_position)
 {
     if (type == "Cruiser")
-        return shared_ptr<Ship>(new Cruiser(name, initial_position));
+        return shared_ptr<Ship>(new Cruiser(model, name, initial_position));
     else if (type == "Tanker")
-        return shared_ptr<Ship>(new Tanker(name, initial_position));
+        return shared_ptr<Ship>(new Tanker(model, name, initial_position));
     else if (type == "Cruise_ship")
-        return shared_ptr<Ship>(new Cruise_ship(name, initial_position));
+        return shared_ptr<Ship>(new Cruise_ship(model, name, initial_position));
     else
         throw Error("Trying to create ship of unknown type!");
 }
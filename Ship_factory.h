@@ -6,12 +6,14 @@
 
 struct Point;
 class Ship;
+class Model;
 /* This is a very simple form of factory, a function; you supply the information, it creates
 the specified kind of object and returns a pointer to it. The Ship is allocated
 with new, so some other component is resposible for deleting it.
 */
 
 // may throw Error("Trying to create ship of unknown type!")
-std::shared_ptr<Ship> create_ship(const std::string& name, const std::string& type, Point initial_position);
+// the Ship belongs to the Model
+std::shared_ptr<Ship> create_ship(Model& model, const std::string& name, const std::string& type, Point initial_position);
 
 #endif
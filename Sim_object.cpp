@@ -1 +1,19 @@
 #include "Sim_object.h"
+#include "View.h"
+#include "Model.h"
+
+void Sim_object::get_current_state(Object_state& state) const
+{
+    state.name = name;
+    state.location = get_location();
+}
+
+std::ostream& Sim_object::get_output() const
+{
+    return model.get_output();
+}
+
+bool Sim_object::log_enabled(Log_category_e category) const
+{
+    return model.log_enabled(category);
+}
@@ -4,14 +4,21 @@
 object's name, and has pure virtual accessor functions for the object's position
 and other information. */
 
+#include "Log.h"
+#include <iosfwd>
 #include <string>
 
 struct Point;
+class Model;
+struct Object_state;
+class Checkpoint_writer;
+class Checkpoint_reader;
 
 class Sim_object {
 public:
     // *** define the constructor in Sim_object.cpp to output the supplied message
-	Sim_object(const std::string& name_) : name(name_) {}
+	// the object belongs to the Model, and lives in its world
+	Sim_object(Model& model_, const std::string& name_) : model(model_), name(name_) {}
 
     // *** define the destructor in Sim_object.cpp to output the supplied message
     virtual ~Sim_object() {}
@@ -21,14 +28,31 @@ public:
     
 	// ask model to notify views of current state
     virtual void broadcast_current_state() {}
+    
+    // fill in the name and location of the current state; derived classes add to it
+    virtual void get_current_state(Object_state& state) const;
+    
+    // write the object's state, other than its name, to a checkpoint, and read it
+    // back into an object created with the same name
+    virtual void save_state(Checkpoint_writer& writer) const = 0;
+    virtual void load_state(Checkpoint_reader& reader) = 0;
 
 	/* Interface for derived classes */
 	// *** declare the following as pure virtual functions 
 	virtual Point get_location() const = 0;
-	virtual void describe() const = 0;
+	virtual void describe(std::ostream& os) const = 0;
 	virtual void update() = 0;
 	
+protected:
+	Model& get_model() const
+		{return model;}
+	// where the object's messages go: the Model's output
+	std::ostream& get_output() const;
+	// whether the Model prints the object's messages of the category
+	bool log_enabled(Log_category_e category) const;
+	
 private:
+	Model& model;
 	std::string name;
 };
 
@@ -1,11 +1,14 @@
 #include "Tanker.h"
+#include "Log.h"
+#include "Fixed_format.h"
+#include "Checkpoint.h"
 #include "Utility.h"
 #include "Island.h"
 #include <iostream>
 #include <cassert>
 
 using std::string;
-using std::cout; using std::endl;
+using std::endl;
 using std::shared_ptr;
 
 
@@ -26,35 +29,54 @@ void Tanker::stop()
 {
     Ship::stop();
     clear_destination();
-    cout << get_name() << " now has no cargo destinations" << endl;
+    if (log_enabled(LOG_CARGO))
+        get_output() << get_name() << " now has no cargo destinations" << endl;
 }
 
-void Tanker::describe() const
+void Tanker::save_state(Checkpoint_writer& writer) const
 {
-    cout << "\nTanker ";
-    Ship::describe();
-    cout << "Cargo: " << cargo << " tons";
+    Ship::save_state(writer);
+    writer.put_double(cargo);
+    writer.put_unsigned(tanker_state);
+    writer.put_object(load_destination.get());
+    writer.put_object(unload_destination.get());
+}
+
+void Tanker::load_state(Checkpoint_reader& reader)
+{
+    Ship::load_state(reader);
+    cargo = reader.get_double();
+    tanker_state = Tanker_state_e(reader.get_enum(MOVING_TO_UNLOADING + 1));
+    load_destination = reader.get_island_ptr();
+    unload_destination = reader.get_island_ptr();
+}
+
+void Tanker::describe(std::ostream& os) const
+{
+    os << "\nTanker ";
+    Ship::describe(os);
+    os << "Cargo: " << Fixed_value(cargo) << " tons";
     switch (tanker_state) {
         case NO_CARGO_DESTINATIONS:
-            cout << ", no cargo destinations";
+            os << ", no cargo destinations";
             break;
         case UNLOADING:
-            cout << ", unloading";
+            os << ", unloading";
             break;
         case MOVING_TO_LOADING:
-            cout << ", moving to loading destination";
+            os << ", moving to loading destination";
             break;
         case LOADING:
-            cout << ", loading";
+            os << ", loading";
             break;
         case MOVING_TO_UNLOADING:
-            cout << ", moving to unloading destination";
+            os << ", moving to unloading destination";
             break;
         default:
             assert(false);
             break;
     }
-    cout << endl;
+    os << endl;
 }
 
 void Tanker::set_load_destination(shared_ptr<Island> destination)
@@ -63,7 +85,8 @@ void Tanker::set_load_destination(shared_ptr<Island> destination)
     load_destination = destination;
     if (destination == unload_destination)
         throw Error("Load and unload cargo destinations are the same!");
-     cout <<  get_name() << " will load at " << destination->get_name() << endl;
+    if (log_enabled(LOG_CARGO))
+        get_output() <<  get_name() << " will load at " << destination->get_name() << endl;
     if (unload_destination)
         start_cycle();
 }
@@ -75,7 +98,8 @@ void Tanker::set_unload_destination(shared_ptr<Island> destination)
     unload_destination = destination;
     if (destination == load_destination)
         throw Error("Load and unload cargo destinations are the same!");
-    cout << get_name() << " will unload at " << destination->get_name() << endl;
+    if (log_enabled(LOG_CARGO))
+        get_output() << get_name() << " will unload at " << destination->get_name() << endl;
     if (load_destination)
         start_cycle();
 }
@@ -114,7 +138,8 @@ void Tanker::update()
     if (!can_move()) {
         if (tanker_state != NO_CARGO_DESTINATIONS) {
             clear_destination();
-            cout << get_name() << " now has no cargo destinations" << endl;
+            if (log_enabled(LOG_CARGO))
+                get_output() << get_name() << " now has no cargo destinations" << endl;
         }
         return;
     }
@@ -145,7 +170,8 @@ void Tanker::update()
             }
             else {
                 cargo += load_destination->provide_fuel(cargo_needed);
-                cout << get_name() <<  " now has " <<cargo << " of cargo" << endl;
+                if (log_enabled(LOG_CARGO))
+                    get_output() << get_name() <<  " now has " << Fixed_value(cargo) << " of cargo" << endl;
             }
             break;
         }
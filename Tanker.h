@@ -25,8 +25,8 @@ class Island;
 class Tanker : public Ship {
 public:
 	// initialize
-	Tanker(const std::string& name_, Point position_) :
-    Ship(name_, position_, 100., 10., 2., 0), cargo_capacity(1000.), cargo(0.),
+	Tanker(Model& model_, const std::string& name_, Point position_) :
+    Ship(model_, name_, position_, 100., 10., 2., 0), cargo_capacity(1000.), cargo(0.),
     tanker_state(NO_CARGO_DESTINATIONS), load_destination(nullptr),
     unload_destination(nullptr) {}
 	
@@ -47,7 +47,11 @@ public:
 	
 	void update() override;
     
-	void describe() const override;
+	void describe(std::ostream& os) const override;
+	const char* get_type_name() const override
+		{return "Tanker";}
+	void save_state(Checkpoint_writer& writer) const override;
+	void load_state(Checkpoint_reader& reader) override;
     
 private:
     enum Tanker_state_e {NO_CARGO_DESTINATIONS, UNLOADING, MOVING_TO_LOADING,
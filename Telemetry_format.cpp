@@ -0,0 +1,67 @@
+#include "Telemetry_format.h"
+#include <cmath>
+#include <istream>
+
+using std::string;
+
+// the bits of a varint byte that hold the number, and the bit set if more bytes follow
+const unsigned varint_value_mask_c = 0x7f;
+const unsigned varint_more_c = 0x80;
+const int varint_shift_c = 7;
+const int max_varint_shift_c = 63;
+
+long long to_telemetry_units(double value)
+{
+    return std::llround(value * telemetry_units_per_c);
+}
+
+void append_varint(string& bytes, unsigned long long value)
+{
+    while (value > varint_value_mask_c) {
+        bytes += char((value & varint_value_mask_c) | varint_more_c);
+        value >>= varint_shift_c;
+    }
+    bytes += char(value);
+}
+
+void append_zigzag(string& bytes, long long value)
+{
+    unsigned long long bits = value;
+    append_varint(bytes, value < 0 ? ~(bits << 1) : bits << 1);
+}
+
+bool read_varint(std::istream& is, unsigned long long& value)
+{
+    value = 0;
+    for (int shift = 0; shift <= max_varint_shift_c; shift += varint_shift_c) {
+        int c = is.get();
+        if (c == std::istream::traits_type::eof())
+            return false;
+        value |= static_cast<unsigned long long>(c & varint_value_mask_c) << shift;
+        if (!(c & varint_more_c))
+            return true;
+    }
+    return false;
+}
+
+bool read_varint(const string& bytes, std::size_t& position, unsigned long long& value)
+{
+    value = 0;
+    for (int shift = 0; shift <= max_varint_shift_c && position < bytes.size();
+         shift += varint_shift_c) {
+        unsigned char c = bytes[position++];
+        value |= static_cast<unsigned long long>(c & varint_value_mask_c) << shift;
+        if (!(c & varint_more_c))
+            return true;
+    }
+    return false;
+}
+
+bool read_zigzag(std::istream& is, long long& value)
+{
+    unsigned long long bits;
+    if (!read_varint(is, bits))
+        return false;
+    value = (bits & 1) ? ~(bits >> 1) : bits >> 1;
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef TELEMETRY_FORMAT_H
+#define TELEMETRY_FORMAT_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+/*
+The binary format of a telemetry file, shared by the Telemetry_view that writes it and
+the tool that converts it to CSV.
+
+A file starts with the magic bytes and a version byte, followed by a frame for each
+update of the simulation:
+	frame:	varint time since the previous frame (or since 0), varint number of records,
+			then the records
+	record:	varint object id, a byte of Telemetry_field_e bits, then the fields present:
+			NAME		varint length and the bytes of the name
+			LOCATION	zigzag varints of the changes in x and y
+			COURSE, SPEED, FUEL	zigzag varint of the change
+			STATE		one byte, a Telemetry_state_e
+An object gets the next id when it is first recorded, and its record then carries its
+name. Numbers are recorded in units of 1/telemetry_units_per_c, as the change from the
+last value recorded for the object, which starts at zero; only fields that changed
+are recorded.
+*/
+
+const char telemetry_magic_c[] = {'P', '5', 'T', 'L'};
+const unsigned char telemetry_version_c = 1;
+const double telemetry_units_per_c = 1000.;
+
+enum Telemetry_field_e {TELEMETRY_NAME = 1, TELEMETRY_LOCATION = 2, TELEMETRY_COURSE = 4,
+	TELEMETRY_SPEED = 8, TELEMETRY_FUEL = 16, TELEMETRY_STATE = 32};
+
+enum Telemetry_state_e {TELEMETRY_STOPPED, TELEMETRY_MOVING, TELEMETRY_GONE};
+
+// the value in recording units
+long long to_telemetry_units(double value);
+
+// append an unsigned number in 7-bit groups, low first, with the high bit set in all
+// but the last byte
+void append_varint(std::string& bytes, unsigned long long value);
+// append a signed number as a varint, mapped so that small magnitudes stay short
+void append_zigzag(std::string& bytes, long long value);
+
+// read numbers appended as above; return false at the end of the input
+bool read_varint(std::istream& is, unsigned long long& value);
+bool read_zigzag(std::istream& is, long long& value);
+// read a varint from the bytes at the position, advancing it
+bool read_varint(const std::string& bytes, std::size_t& position, unsigned long long& value);
+
+#endif
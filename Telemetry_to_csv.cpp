@@ -0,0 +1,126 @@
+/*
+Convert a telemetry file written by a Telemetry_view to CSV on standard output:
+a row for each record, giving the object's full state after the record.
+
+usage: telemetry_csvexe file
+*/
+
+#include "Telemetry_format.h"
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cout; using std::cerr; using std::endl;
+using std::string;
+using std::vector;
+
+const char* const state_names_c[] = {"stopped", "moving", "gone"};
+
+struct Object_values {
+    string name;
+    long long x, y, course, speed, fuel;
+    int state;
+};
+
+// the value in recording units as a number
+static double from_units(long long value)
+{
+    return value / telemetry_units_per_c;
+}
+
+static bool read_record(std::istream& is, vector<Object_values>& objects, int time);
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        cerr << "usage: " << argv[0] << " file" << endl;
+        return 1;
+    }
+    std::ifstream file(argv[1], std::ios::binary);
+    char header[sizeof(telemetry_magic_c) + 1];
+    if (!file.read(header, sizeof(header)) ||
+        std::memcmp(header, telemetry_magic_c, sizeof(telemetry_magic_c)) ||
+        header[sizeof(telemetry_magic_c)] != char(telemetry_version_c)) {
+        cerr << "Not a telemetry file!" << endl;
+        return 1;
+    }
+    cout << std::fixed << std::setprecision(3);
+    cout << "time,name,x,y,course,speed,fuel,state" << endl;
+    vector<Object_values> objects;
+    int time = 0;
+    unsigned long long time_step, n_records;
+    while (read_varint(file, time_step)) {
+        time += int(time_step);
+        if (!read_varint(file, n_records)) {
+            cerr << "Truncated telemetry file!" << endl;
+            return 1;
+        }
+        for (unsigned long long i = 0; i < n_records; i++) {
+            if (!read_record(file, objects, time)) {
+                cerr << "Truncated telemetry file!" << endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// read a record, apply it to the object, and write the object's row
+static bool read_record(std::istream& is, vector<Object_values>& objects, int time)
+{
+    unsigned long long id, length;
+    if (!read_varint(is, id))
+        return false;
+    int fields = is.get();
+    if (fields == std::istream::traits_type::eof())
+        return false;
+    if (id == objects.size())
+        objects.push_back(Object_values{string(), 0, 0, 0, 0, 0, TELEMETRY_STOPPED});
+    else if (id > objects.size())
+        return false;
+    Object_values& object = objects[id];
+    long long change;
+    if (fields & TELEMETRY_NAME) {
+        if (!read_varint(is, length))
+            return false;
+        object.name.resize(length);
+        if (!is.read(&object.name[0], length))
+            return false;
+    }
+    if (fields & TELEMETRY_LOCATION) {
+        if (!read_zigzag(is, change))
+            return false;
+        object.x += change;
+        if (!read_zigzag(is, change))
+            return false;
+        object.y += change;
+    }
+    if (fields & TELEMETRY_COURSE) {
+        if (!read_zigzag(is, change))
+            return false;
+        object.course += change;
+    }
+    if (fields & TELEMETRY_SPEED) {
+        if (!read_zigzag(is, change))
+            return false;
+        object.speed += change;
+    }
+    if (fields & TELEMETRY_FUEL) {
+        if (!read_zigzag(is, change))
+            return false;
+        object.fuel += change;
+    }
+    if (fields & TELEMETRY_STATE) {
+        object.state = is.get();
+        if (object.state < TELEMETRY_STOPPED || object.state > TELEMETRY_GONE)
+            return false;
+    }
+    cout << time << ',' << object.name << ',' << from_units(object.x) << ','
+        << from_units(object.y) << ',' << from_units(object.course) << ','
+        << from_units(object.speed) << ',' << from_units(object.fuel) << ','
+        << state_names_c[object.state] << '\n';
+    return true;
+}
@@ -0,0 +1,177 @@
+#include "Telemetry_view.h"
+#include "Utility.h"
+
+using std::string;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+
+Telemetry_view::Telemetry_view(const string& filename) :
+    last_frame_time(0), file(filename, std::ios::binary | std::ios::trunc), stopping(false)
+{
+    if (!file)
+        throw Error("Could not open telemetry file!");
+    pending.assign(telemetry_magic_c, sizeof(telemetry_magic_c));
+    pending += char(telemetry_version_c);
+    writer = std::thread(&Telemetry_view::write_pending, this);
+}
+
+Telemetry_view::~Telemetry_view()
+{
+    {
+        lock_guard<mutex> lock(writer_mutex);
+        stopping = true;
+    }
+    writer_changed.notify_all();
+    writer.join();
+}
+
+void Telemetry_view::update_location(const string& name, Point location)
+{
+    Object_record& record = get_changed_record(name);
+    record.current.x = to_telemetry_units(location.x);
+    record.current.y = to_telemetry_units(location.y);
+}
+
+void Telemetry_view::update_fuel(const string& name, double fuel)
+{
+    get_changed_record(name).current.fuel = to_telemetry_units(fuel);
+}
+
+void Telemetry_view::update_course(const string& name, double course)
+{
+    get_changed_record(name).current.course = to_telemetry_units(course);
+}
+
+void Telemetry_view::update_speed(const string& name, double speed)
+{
+    Object_record& record = get_changed_record(name);
+    record.current.speed = to_telemetry_units(speed);
+    record.current.state = speed != 0. ? TELEMETRY_MOVING : TELEMETRY_STOPPED;
+}
+
+void Telemetry_view::update_remove(const string& name)
+{
+    if (objects.find(name) == objects.end())
+        return;
+    get_changed_record(name).current.state = TELEMETRY_GONE;
+}
+
+void Telemetry_view::clear()
+{
+    for (auto& object : objects)
+        get_changed_record(object.first).current.state = TELEMETRY_GONE;
+}
+
+void Telemetry_view::update_tick(int time)
+{
+    frame_records.clear();
+    unsigned long n_records = 0;
+    for (auto object_ptr : changed_objects) {
+        if (append_record(frame_records, object_ptr->first, object_ptr->second))
+            n_records++;
+        object_ptr->second.changed = false;
+    }
+    changed_objects.clear();
+    if (!n_records)
+        return;
+    string frame;
+    append_varint(frame, time - last_frame_time);
+    append_varint(frame, n_records);
+    frame += frame_records;
+    last_frame_time = time;
+    hand_off(frame);
+}
+
+// A new object starts with nothing recorded, so everything about it is a change.
+// Hearing about a gone object again, as after a checkpoint is loaded, brings it back.
+Telemetry_view::Object_record& Telemetry_view::get_changed_record(const string& name)
+{
+    auto object_it = objects.find(name);
+    if (object_it == objects.end()) {
+        Object_record record;
+        record.id = objects.size();
+        record.named = false;
+        record.changed = false;
+        record.current = Values{0, 0, 0, 0, 0, TELEMETRY_STOPPED};
+        record.recorded = record.current;
+        object_it = objects.insert(Objects_t::value_type(name, record)).first;
+    }
+    if (object_it->second.current.state == TELEMETRY_GONE)
+        object_it->second.current.state = object_it->second.current.speed != 0 ?
+            TELEMETRY_MOVING : TELEMETRY_STOPPED;
+    if (!object_it->second.changed) {
+        object_it->second.changed = true;
+        changed_objects.push_back(&*object_it);
+    }
+    return object_it->second;
+}
+
+bool Telemetry_view::append_record(string& bytes, const string& name, Object_record& record)
+{
+    const Values& current = record.current;
+    Values& recorded = record.recorded;
+    unsigned fields = 0;
+    if (!record.named)
+        fields |= TELEMETRY_NAME | TELEMETRY_STATE;
+    if (current.x != recorded.x || current.y != recorded.y)
+        fields |= TELEMETRY_LOCATION;
+    if (current.course != recorded.course)
+        fields |= TELEMETRY_COURSE;
+    if (current.speed != recorded.speed)
+        fields |= TELEMETRY_SPEED;
+    if (current.fuel != recorded.fuel)
+        fields |= TELEMETRY_FUEL;
+    if (current.state != recorded.state)
+        fields |= TELEMETRY_STATE;
+    if (!fields)
+        return false;
+    append_varint(bytes, record.id);
+    bytes += char(fields);
+    if (fields & TELEMETRY_NAME) {
+        append_varint(bytes, name.size());
+        bytes += name;
+    }
+    if (fields & TELEMETRY_LOCATION) {
+        append_zigzag(bytes, current.x - recorded.x);
+        append_zigzag(bytes, current.y - recorded.y);
+    }
+    if (fields & TELEMETRY_COURSE)
+        append_zigzag(bytes, current.course - recorded.course);
+    if (fields & TELEMETRY_SPEED)
+        append_zigzag(bytes, current.speed - recorded.speed);
+    if (fields & TELEMETRY_FUEL)
+        append_zigzag(bytes, current.fuel - recorded.fuel);
+    if (fields & TELEMETRY_STATE)
+        bytes += char(current.state);
+    record.named = true;
+    recorded = current;
+    return true;
+}
+
+void Telemetry_view::hand_off(const string& bytes)
+{
+    {
+        lock_guard<mutex> lock(writer_mutex);
+        pending += bytes;
+    }
+    writer_changed.notify_all();
+}
+
+// The writer takes everything pending at once, so frames handed off while it writes
+// are written next, in order.
+void Telemetry_view::write_pending()
+{
+    unique_lock<mutex> lock(writer_mutex);
+    while (true) {
+        writer_changed.wait(lock, [this] {return !pending.empty() || stopping;});
+        if (pending.empty())
+            break;
+        string bytes;
+        bytes.swap(pending);
+        lock.unlock();
+        file.write(bytes.data(), bytes.size());
+        lock.lock();
+    }
+    file.flush();
+}
@@ -0,0 +1,91 @@
+#ifndef TELEMETRY_VIEW_H
+#define TELEMETRY_VIEW_H
+
+#include "View.h"
+#include "Telemetry_format.h"
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+A Telemetry_view records the objects' changes in a binary file, in the format described
+in Telemetry_format.h, for processing after the run; it draws nothing. The changes made
+during each update of the simulation are recorded as one frame at the end of the update:
+a record for each object that changed, holding only what changed. An object's state is
+whether it is moving, stopped, or gone.
+
+Frames are encoded as the simulation runs and handed to a writer thread, so the
+simulation never waits for the file.
+*/
+
+class Telemetry_view : public View {
+public:
+	// open the file, write its header, and start the writer thread
+	// will throw Error("Could not open telemetry file!")
+	explicit Telemetry_view(const std::string& filename);
+	// write everything handed off, then stop the writer thread
+	~Telemetry_view();
+
+	void update_location(const std::string& name, Point location) override;
+	void update_fuel(const std::string& name, double fuel) override;
+	void update_course(const std::string& name, double course) override;
+	void update_speed(const std::string& name, double speed) override;
+
+	// Record the object as gone; no error if the name is not present.
+	void update_remove(const std::string& name) override;
+
+	// record the changes since the last frame as a frame for the time
+	void update_tick(int time) override;
+
+	// there is nothing to draw
+	void draw_on(std::ostream&) override {}
+
+	// record all objects as gone
+	void clear() override;
+
+private:
+	struct Values {
+		long long x, y, course, speed, fuel;	// in recording units
+		Telemetry_state_e state;
+	};
+	struct Object_record {
+		unsigned long id;
+		bool named;		// the name has been recorded
+		bool changed;	// listed in changed_objects
+		Values current;
+		Values recorded;	// as of the last frame
+	};
+	typedef std::map<std::string, Object_record> Objects_t;
+
+	Objects_t objects;
+	std::vector<Objects_t::value_type*> changed_objects;	// since the last frame
+	int last_frame_time;
+	std::string frame_records;	// reused for encoding each frame
+
+	// shared with the writer thread
+	std::ofstream file;
+	std::thread writer;
+	std::mutex writer_mutex;
+	std::condition_variable writer_changed;
+	std::string pending;	// handed to the writer, not yet written
+	bool stopping;
+
+	// the record of the object, listed as changed
+	Object_record& get_changed_record(const std::string& name);
+	// append the fields that changed since the last frame, and return whether any did
+	bool append_record(std::string& bytes, const std::string& name, Object_record& record);
+	void hand_off(const std::string& bytes);
+	void write_pending();
+
+	// disallow copy/move construction or assignment
+	Telemetry_view(const Telemetry_view&) = delete;
+	Telemetry_view(Telemetry_view&&) = delete;
+	Telemetry_view& operator= (const Telemetry_view&) = delete;
+	Telemetry_view& operator= (Telemetry_view&&) = delete;
+};
+
+#endif
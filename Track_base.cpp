@@ -8,12 +8,12 @@ using namespace std;
 
 /* Public Function Definitions */
 
-Track_base::Track_base() : altitude(0.) {}
+Track_base::Track_base() {}
 
-Track_base::Track_base(Point in_position) : position(in_position), altitude(0.) {}
+Track_base::Track_base(Point in_position) : position(in_position) {}
 
-Track_base::Track_base(Point in_position, Course_speed in_course_speed, double in_altitude) :
-		position(in_position), course_speed(in_course_speed), altitude(in_altitude) {}
+Track_base::Track_base(Point in_position, Course_speed in_course_speed) :
+		position(in_position), course_speed(in_course_speed) {}
 
 Track_base::~Track_base() {}
 
@@ -68,3 +68,22 @@ void Track_base::update_position(double time_increment)
 	position = position + (course_speed * time_increment);
 }
 
+
+// update the position of this object, including drift
+void Track_base::update_position(double time_increment, const Cartesian_vector& drift)
+{
+	update_position(time_increment);
+	if (drift.delta_x != 0. || drift.delta_y != 0.)
+		position = position + (drift * time_increment);
+}
+
+// update the position of this object along a great circle, including drift
+void Track_base::update_position_great_circle(double time_increment, const Geo_projection& projection,
+	const Cartesian_vector& drift)
+{
+	Geo_position new_position = great_circle_destination(projection.to_geo_position(position),
+		course_speed.course, course_speed.speed * time_increment);
+	position = projection.to_point(new_position);
+	if (drift.delta_x != 0. || drift.delta_y != 0.)
+		position = position + (drift * time_increment);
+}
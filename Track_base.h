@@ -1,7 +1,7 @@
 /*
 The Track_base class defines a base class of track objects, which are objects that move
-according to course and speed. They have a Point, a Course_speed, and an altitude 
-(set to zero for surface tracks). When updated, they change their Point 
+according to course and speed. They have a Point and a Course_speed; only surface
+tracks are simulated, so there is no altitude. When updated, they change their Point 
 as a function of their Course_speed.
 
 Various values can be calculated for this track's position or motion as viewed from
@@ -19,7 +19,7 @@ public:
 	// Constructors
 	Track_base();
 	Track_base(Point in_position);
-	Track_base(Point in_position, Course_speed in_course_speed, double in_altitude = 0.);
+	Track_base(Point in_position, Course_speed in_course_speed);
 	virtual ~Track_base();
 	
 	// Readers
@@ -31,8 +31,6 @@ public:
 		{return course_speed.course;}
 	double get_speed() const 
 		{return course_speed.speed;}
-	double get_altitude() const
-		{return altitude;}
 			
 	// Writers
 	void set_position(Point in_position)
@@ -43,8 +41,6 @@ public:
 		{course_speed.course = in_course;}
 	void set_speed (double in_speed)
 		{course_speed.speed = in_speed;}
-	void set_altitude (double in_altitude)
-		{altitude = in_altitude;}
 		
 	/* Calculate track motion analysis results from this track and a supplied 
 	other track or position - the other track is normally "ownship", so
@@ -67,10 +63,18 @@ public:
 	// which is multiplied by the speed to get the distance to be moved
 	virtual void update_position(double time_increment);
 	
+	// Update the position as above, then also displace it by the drift velocity
+	// (such as a current) for the same time increment
+	void update_position(double time_increment, const Cartesian_vector& drift);
+	
+	// Update the position by sailing the great circle that starts out on the current course,
+	// treating the position as a Point in the supplied projection, then displace it by the drift
+	void update_position_great_circle(double time_increment, const Geo_projection& projection,
+		const Cartesian_vector& drift);
+	
 private:
 	Point position;				// Current location
 	Course_speed course_speed;			// Current course & speed
-	double altitude;					// Current altitude
 };
 
 #endif
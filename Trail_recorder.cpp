@@ -0,0 +1,215 @@
+#include "Trail_recorder.h"
+#include "Telemetry_format.h"
+#include <algorithm>
+#include <cmath>
+
+using std::string;
+using std::vector;
+using std::map;
+
+// locations are recorded in units of 1/trail_units_per_c
+const double trail_units_per_c = 1000.;
+// how far a point may be from the simplified trail, in recording units
+const double trail_tolerance_c = 0.05 * trail_units_per_c;
+// the bits of a varint byte that hold the number, and the bit set if more bytes follow
+const unsigned varint_value_mask_c = 0x7f;
+const unsigned varint_more_c = 0x80;
+const int varint_shift_c = 7;
+
+// the distance of the point from the line segment between the ends
+static double distance_to_segment(double x, double y, double x1, double y1, double x2, double y2)
+{
+    double dx = x2 - x1, dy = y2 - y1;
+    double length_squared = dx * dx + dy * dy;
+    double t = length_squared > 0. ? ((x - x1) * dx + (y - y1) * dy) / length_squared : 0.;
+    t = std::max(0., std::min(1., t));
+    return std::hypot(x - (x1 + t * dx), y - (y1 + t * dy));
+}
+
+Ship_trail::Ship_trail() : empty(true), ring_start(0), ring_length(0)
+{
+}
+
+// The newest point becomes a vertex when the line from the newest vertex to the new
+// point no longer passes close to all the points since, or there are too many of them.
+void Ship_trail::add(int time, Point location)
+{
+    Fixed_vertex point{time, std::llround(location.x * trail_units_per_c),
+        std::llround(location.y * trail_units_per_c)};
+    if (empty) {
+        oldest = newest = point;
+        empty = false;
+        return;
+    }
+    bool replaces_pending = pending.size() < max_pending_c;
+    for (auto& pending_point : pending) {
+        if (!replaces_pending)
+            break;
+        replaces_pending = distance_to_segment(pending_point.x, pending_point.y,
+            newest.x, newest.y, point.x, point.y) <= trail_tolerance_c;
+    }
+    if (!replaces_pending) {
+        add_vertex(pending.back());
+        pending.clear();
+    }
+    pending.push_back(point);
+}
+
+// The oldest vertex is kept while the next one is at or before the time, so that the
+// trail still reaches back to the time.
+void Ship_trail::forget_before(int time)
+{
+    int length;
+    while (ring_length > 0 && oldest.time + read_change(0, length).time <= time)
+        drop_oldest();
+    if (ring_length == 0 && !pending.empty() && pending.back().time <= time) {
+        oldest = newest = pending.back();
+        pending.clear();
+    }
+}
+
+// The trail is taken to have been at the first vertex until the second.
+vector<Ship_trail::Vertex> Ship_trail::get_vertices(int start_time) const
+{
+    vector<Vertex> vertices;
+    if (empty)
+        return vertices;
+    Fixed_vertex vertex = oldest;
+    int position = 0, length;
+    while (true) {
+        vertices.push_back(Vertex{vertex.time,
+            Point(vertex.x / trail_units_per_c, vertex.y / trail_units_per_c)});
+        if (position == ring_length)
+            break;
+        Fixed_vertex change = read_change(position, length);
+        vertex.time += change.time;
+        vertex.x += change.x;
+        vertex.y += change.y;
+        position += length;
+    }
+    if (!pending.empty())
+        vertices.push_back(Vertex{pending.back().time,
+            Point(pending.back().x / trail_units_per_c, pending.back().y / trail_units_per_c)});
+    // forget_before leaves the second vertex after the time
+    Vertex& first = vertices.front();
+    if (first.time >= start_time)
+        return vertices;
+    if (vertices.size() > 1) {
+        const Vertex& next = vertices[1];
+        double fraction = double(start_time - first.time) / (next.time - first.time);
+        first.location = Point(first.location.x + fraction * (next.location.x - first.location.x),
+            first.location.y + fraction * (next.location.y - first.location.y));
+    }
+    first.time = start_time;
+    return vertices;
+}
+
+// the oldest vertices are dropped to make room
+void Ship_trail::add_vertex(const Fixed_vertex& vertex)
+{
+    string bytes;
+    append_varint(bytes, vertex.time - newest.time);
+    append_zigzag(bytes, vertex.x - newest.x);
+    append_zigzag(bytes, vertex.y - newest.y);
+    while (ring_size_c - ring_length < int(bytes.size()))
+        drop_oldest();
+    for (char byte : bytes)
+        ring[(ring_start + ring_length++) % ring_size_c] = byte;
+    newest = vertex;
+}
+
+Ship_trail::Fixed_vertex Ship_trail::read_change(int position, int& length) const
+{
+    unsigned long long values[3] = {0, 0, 0};
+    length = 0;
+    for (auto& value : values) {
+        for (int shift = 0; ; shift += varint_shift_c) {
+            unsigned char c = ring[(ring_start + position + length++) % ring_size_c];
+            value |= static_cast<unsigned long long>(c & varint_value_mask_c) << shift;
+            if (!(c & varint_more_c))
+                break;
+        }
+    }
+    // the location changes are zigzag-mapped
+    for (int i = 1; i < 3; i++)
+        values[i] = (values[i] & 1) ? ~(values[i] >> 1) : values[i] >> 1;
+    return Fixed_vertex{int(values[0]), static_cast<long long>(values[1]),
+        static_cast<long long>(values[2])};
+}
+
+void Ship_trail::drop_oldest()
+{
+    int length;
+    Fixed_vertex change = read_change(0, length);
+    oldest.time += change.time;
+    oldest.x += change.x;
+    oldest.y += change.y;
+    ring_start = (ring_start + length) % ring_size_c;
+    ring_length -= length;
+}
+
+Trail_recorder::Trail_recorder(int hours_, int time_) :
+    hours(hours_), time(time_), time_known(true)
+{
+}
+
+// An object with no trail starts one at the current time, unless the time isn't known.
+void Trail_recorder::update_location(const string& name, Point location)
+{
+    if (trails.count(name) || starts.count(name))
+        moved[name] = location;
+    else if (time_known)
+        trails[name].add(time, location);
+    else
+        starts[name] = location;
+}
+
+// Objects seen while the time wasn't known were seen before this update.
+void Trail_recorder::update_tick(int time_)
+{
+    time = time_;
+    for (auto& start_pair : starts)
+        trails[start_pair.first].add(time - 1, start_pair.second);
+    starts.clear();
+    time_known = true;
+    for (auto& moved_pair : moved)
+        trails[moved_pair.first].add(time, moved_pair.second);
+    moved.clear();
+    for (auto& trail_pair : trails)
+        trail_pair.second.forget_before(time - hours);
+}
+
+void Trail_recorder::update_remove(const string& name)
+{
+    trails.erase(name);
+    moved.erase(name);
+    starts.erase(name);
+}
+
+void Trail_recorder::clear()
+{
+    trails.clear();
+    moved.clear();
+    starts.clear();
+    time_known = false;
+}
+
+vector<Ship_trail::Vertex> Trail_recorder::get_trail(const string& name) const
+{
+    auto trail_it = trails.find(name);
+    if (trail_it == trails.end())
+        return vector<Ship_trail::Vertex>();
+    return trail_it->second.get_vertices(time - hours);
+}
+
+vector<vector<Point>> Trail_recorder::get_paths() const
+{
+    vector<vector<Point>> paths;
+    for (auto& trail_pair : trails) {
+        vector<Point> path;
+        for (auto& vertex : trail_pair.second.get_vertices(time - hours))
+            path.push_back(vertex.location);
+        paths.push_back(path);
+    }
+    return paths;
+}
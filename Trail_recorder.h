@@ -0,0 +1,107 @@
+#ifndef TRAIL_RECORDER_H
+#define TRAIL_RECORDER_H
+
+#include "View.h"
+#include "Geometry.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+A Trail_recorder keeps the recent track of every object - where it has been over the
+last so many hours - for the map view to draw and the history command to print. It is
+attached to the Model like a View, but draws nothing itself.
+
+Each track is a Ship_trail, which simplifies the path as it is recorded, in the manner
+of the Douglas-Peucker algorithm applied online: a new location replaces the points
+since the last vertex as long as none of them is farther than a tolerance from the line
+between that vertex and the new location; once one is, the latest point becomes a
+vertex. A ship sailing a steady course thus takes a vertex only every so many updates,
+since the points waiting on the next vertex are limited too.
+The vertices are kept in a fixed-size ring of bytes, each as varints of the changes in
+time and location from the one before, with only the oldest vertex kept whole;
+when the ring is full, or a vertex is older than the trail's length, the oldest is
+dropped. The memory for each track is therefore bounded, however long the simulation runs.
+The oldest vertex kept may be older than the trail's length, so the trail is cut where
+it was at that length when its vertices are taken.
+*/
+
+class Ship_trail {
+public:
+	struct Vertex {
+		int time;
+		Point location;
+	};
+
+	Ship_trail();
+
+	// record the location at the time, which is later than any recorded before
+	void add(int time, Point location);
+
+	// forget what is only needed to draw the trail before the time
+	void forget_before(int time);
+
+	// the vertices from the time on, oldest first, ending with the last location
+	// recorded; an older first vertex is moved along the trail to the time
+	std::vector<Vertex> get_vertices(int start_time) const;
+
+private:
+	// a location in whole recording units
+	struct Fixed_vertex {
+		int time;
+		long long x, y;
+	};
+	static const int ring_size_c = 96;
+	static const int max_pending_c = 16;
+
+	bool empty;
+	Fixed_vertex oldest;		// the oldest vertex, whole
+	Fixed_vertex newest;		// the vertex the ring ends with
+	char ring[ring_size_c];		// the changes from the oldest to each later vertex
+	int ring_start;
+	int ring_length;
+	// the points recorded since the newest vertex, the last of which ends the trail
+	std::vector<Fixed_vertex> pending;
+
+	void add_vertex(const Fixed_vertex& vertex);
+	// the change to the vertex after the oldest, and the number of bytes it takes
+	Fixed_vertex read_change(int position, int& length) const;
+	void drop_oldest();
+};
+
+class Trail_recorder : public View {
+public:
+	// record trails of hours, starting at the time
+	Trail_recorder(int hours_, int time_);
+
+	void update_location(const std::string& name, Point location) override;
+
+	// the locations that changed are recorded at the time
+	void update_tick(int time_) override;
+
+	// Remove the object's trail; no error if the name is not present.
+	void update_remove(const std::string& name) override;
+
+	// there is nothing to draw
+	void draw_on(std::ostream&) override {}
+
+	// Forget all trails; the time is not known again until the next update.
+	void clear() override;
+
+	// the vertices of the object's trail over the last hours, oldest first; empty if it
+	// is not known
+	std::vector<Ship_trail::Vertex> get_trail(const std::string& name) const;
+
+	// the locations along every trail
+	std::vector<std::vector<Point>> get_paths() const;
+
+private:
+	int hours;
+	int time;
+	bool time_known;
+	std::map<std::string, Ship_trail> trails;
+	std::map<std::string, Point> moved;		// since the last update
+	std::map<std::string, Point> starts;	// of objects seen while the time is not known
+};
+
+#endif
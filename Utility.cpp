@@ -1,9 +1,54 @@
 #include "Utility.h"
 #include "Island.h"
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// fewer items than this are formatted directly into the stream
+const std::size_t parallel_format_threshold_c = 1000;
+// each thread formats at least this many items
+const std::size_t min_chunk_items_c = 500;
 
 
 bool Island_comp::operator() (const std::shared_ptr<Island> island1,
                  const std::shared_ptr<Island> island2) const
 {
     return island1->get_name() < island2->get_name();
-}
\ No newline at end of file
+}
+
+void format_in_parallel(std::ostream& os, std::size_t n_items,
+                        const std::function<void(std::ostream&, std::size_t)>& format_item)
+{
+    if (n_items < parallel_format_threshold_c) {
+        for (std::size_t i = 0; i < n_items; i++)
+            format_item(os, i);
+        return;
+    }
+    std::size_t n_chunks = std::max<std::size_t>(1, std::min<std::size_t>(
+        std::thread::hardware_concurrency(), n_items / min_chunk_items_c));
+    std::size_t chunk_items = (n_items + n_chunks - 1) / n_chunks;
+    // the threads only read the stream's format, which is copied up front
+    vector<std::ostringstream> chunk_streams(n_chunks);
+    for (auto& chunk_stream : chunk_streams)
+        chunk_stream.copyfmt(os);
+    auto format_chunk = [&](std::size_t chunk) {
+        std::size_t last = std::min(n_items, (chunk + 1) * chunk_items);
+        for (std::size_t i = chunk * chunk_items; i < last; i++)
+            format_item(chunk_streams[chunk], i);
+    };
+    vector<std::thread> threads;
+    for (std::size_t chunk = 1; chunk < n_chunks; chunk++)
+        threads.push_back(std::thread(format_chunk, chunk));
+    format_chunk(0);
+    for (auto& worker : threads)
+        worker.join();
+    string text;
+    for (auto& chunk_stream : chunk_streams)
+        text += chunk_stream.str();
+    os.write(text.data(), text.size());
+}
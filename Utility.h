@@ -1,7 +1,10 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
+#include <cstddef>
 #include <exception>
+#include <functional>
+#include <iosfwd>
 #include <memory>
 
 class Island;
@@ -20,4 +23,11 @@ struct Island_comp {
                      const std::shared_ptr<Island> island2) const;
 };
 
+// Write n_items items to the stream in order, format_item(os, i) writing item i.
+// Many items are divided into chunks that separate threads format into buffers set
+// up like the stream; the buffers are then written in order with one write, so the
+// result is the same as formatting the items one after another.
+void format_in_parallel(std::ostream& os, std::size_t n_items,
+                        const std::function<void(std::ostream&, std::size_t)>& format_item);
+
 #endif
@@ -1 +1,20 @@
 #include "View.h"
+#include "Interest.h"
+
+void View::update_snapshot(const std::vector<Object_state>& states, unsigned attributes)
+{
+    for (auto& state : states) {
+        if (attributes & LOCATION_ATTRIBUTE)
+            update_location(state.name, state.location);
+        if (!state.has_motion)
+            continue;
+        if (attributes & TYPE_ATTRIBUTE)
+            update_type(state.name, state.type_name);
+        if (attributes & FUEL_ATTRIBUTE)
+            update_fuel(state.name, state.fuel);
+        if (attributes & COURSE_ATTRIBUTE)
+            update_course(state.name, state.course);
+        if (attributes & SPEED_ATTRIBUTE)
+            update_speed(state.name, state.speed);
+    }
+}
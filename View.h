@@ -2,10 +2,27 @@
 #define VIEW_H
 
 #include "Geometry.h"
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 
 /* This class provides the interface for all of view objects. */
 
+// The current state of an object, used to bring a newly attached View up to date
+// in one call. Islands have no motion, so only ships have a type, fuel, course, and speed.
+struct Object_state {
+    std::string name;
+    Point location;
+    bool has_motion;
+    std::string type_name;
+    double fuel;
+    double course;
+    double speed;
+    
+    Object_state() : has_motion(false), fuel(0.), course(0.), speed(0.) {}
+};
+
 class View {
 public:
     virtual ~View() {}
@@ -18,11 +35,35 @@ public:
     
     virtual void update_speed(const std::string& name, double speed) {}
     
+    // The ship's type, as given to create_ship; it is sent when the ship appears.
+    virtual void update_type(const std::string& name, const std::string& type_name) {}
+    
+	// The simulation has finished updating all objects; the time is now time.
+	virtual void update_tick(int time) {}
+    
 	// Remove the ship; no error if the name is not present.
 	virtual void update_remove(const std::string& name) = 0;
     
-	// prints out the current map
-	virtual void draw() = 0;
+    // For a View attached with a bounded Interest_region, an object has come into or
+    // gone out of the region. By default these are treated as a location update and a removal.
+    virtual void update_enter(const std::string& name, Point location)
+        {update_location(name, location);}
+    virtual void update_leave(const std::string& name)
+        {update_remove(name);}
+    
+    // Receive the current state of a set of objects, with the attributes given by the
+    // mask of View_attribute_e bits; by default, this is the same as an update for each
+    // attribute of each object.
+    virtual void update_snapshot(const std::vector<Object_state>& states, unsigned attributes);
+    
+	// prints out the current map on the stream
+	virtual void draw_on(std::ostream& os) = 0;
+	
+	// Return a copy that can be drawn later on another thread while this View goes on
+	// being updated, so the copy must not share anything that updates change.
+	// Views that cannot be copied this way return an empty pointer.
+	virtual std::shared_ptr<View> snapshot() const
+		{return nullptr;}
 	
 	// Discard the saved information - drawing will show only a empty pattern
 	virtual void clear() = 0;
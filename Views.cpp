@@ -1,96 +1,450 @@
 #include "Views.h"
 #include "Utility.h"
+#include "Fixed_format.h"
+#include "Checkpoint.h"
+#include "Trail_recorder.h"
 #include <cmath>
+#include <cstdio>
+#include <algorithm>
 #include <vector>
+#include <thread>
+#include <utility>
 #include <iomanip>
 #include <iostream>
+#include <fstream>
 
 
-using std::cout; using std::endl;
+using std::endl;
 using std::vector;
 using std::string;
-using std::ios; using std::setw;
-using std::streamsize;
+using std::setw;
+using std::shared_ptr;
 
 const int axes_label_gap_c = 3;
 const int label_width_c = 4;
 const int sailing_view_field_width_c = 10;
+const int number_buffer_size_c = 64;
+const int max_image_pixels_c = 16384;
+// the density view's level 0 grid: cells per side, cell size, and lower-left corner
+const int density_grid_size_c = 256;
+const double density_cell_size_c = 1.0;
+const Point density_grid_origin_c(-128., -128.);
+const int default_density_zoom_c = 1;
+const int density_display_size_c = 25;
+// characters for increasing counts, starting with none
+const char density_ramp_c[] = ".:-=+*#%@";
+// each thread drawing an image gets at least this many rows
+const int min_band_rows_c = 64;
+// contacts closer or farther than these are not shown in a bridge view
+const double bridge_min_range_c = 0.005;
+const double bridge_max_range_c = 20.;
+// degrees added to each side of the sector searched for a bridge view's contacts
+const double bridge_sector_margin_c = 1.;
+// space left around the objects in a fitted image, as a fraction of their extent
+const double fit_margin_c = 0.05;
+// the smallest area a fitted image will cover, so a single object doesn't fill it
+const double min_fit_extent_c = 1.0;
 
 
-Map_view::Map_view()
+Map_view::Map_view() : live(false), live_frame_valid(false), live_screen_set(false), bounds_valid(true)
 {
     set_defaults();
 }
 
 void Map_view::update_location(const std::string& name, Point location)
 {
-    points[name] = location;
+    auto points_it = points.find(name);
+    if (points_it != points.end()) {
+        if (live_frame_valid)
+            leave_cell(points_it->first, points_it->second);
+        check_leaving_bounds(points_it->second);
+    }
+    if (bounds_valid) {
+        if (points.empty())
+            bounds_min = bounds_max = location;
+        bounds_min = Point(std::min(bounds_min.x, location.x), std::min(bounds_min.y, location.y));
+        bounds_max = Point(std::max(bounds_max.x, location.x), std::max(bounds_max.y, location.y));
+    }
+    if (points_it == points.end())
+        points_it = points.insert(std::make_pair(name, location)).first;
+    else
+        points_it->second = location;
+    if (live_frame_valid)
+        enter_cell(points_it->first, location);
 }
 
 void Map_view::update_remove(const std::string& name)
 {
-    points.erase(name);
+    auto points_it = points.find(name);
+    if (points_it == points.end())
+        return;
+    if (live_frame_valid)
+        leave_cell(points_it->first, points_it->second);
+    check_leaving_bounds(points_it->second);
+    points.erase(points_it);
+}
+
+void Map_view::check_leaving_bounds(Point location)
+{
+    if (location.x == bounds_min.x || location.y == bounds_min.y ||
+        location.x == bounds_max.x || location.y == bounds_max.y)
+        bounds_valid = false;
+}
+
+void Map_view::compute_bounds()
+{
+    bounds_min = bounds_max = points.empty() ? Point() : points.begin()->second;
+    for (auto& map_pair : points) {
+        bounds_min = Point(std::min(bounds_min.x, map_pair.second.x),
+                           std::min(bounds_min.y, map_pair.second.y));
+        bounds_max = Point(std::max(bounds_max.x, map_pair.second.x),
+                           std::max(bounds_max.y, map_pair.second.y));
+    }
+    bounds_valid = true;
+}
+
+// the name is the key in points, which stays put while the object is in the map
+void Map_view::enter_cell(const std::string& name, Point location)
+{
+    int x, y;
+    if (!get_subscripts(x, y, location))
+        return;
+    cell_objects[x * size + y].push_back(&name);
+    dirty_cells.push_back(x * size + y);
 }
 
-void Map_view::draw()
+void Map_view::leave_cell(const std::string& name, Point location)
 {
-    class Cout_format_saver {
-    public:
-        Cout_format_saver() :
-        old_flags(cout.flags()), old_precision(cout.precision()) {}
-        ~Cout_format_saver() {
-            cout.flags(old_flags);
-            cout.precision(old_precision);
+    int x, y;
+    if (!get_subscripts(x, y, location))
+        return;
+    vector<const string*>& objects = cell_objects[x * size + y];
+    objects.erase(std::find(objects.begin(), objects.end(), &name));
+    dirty_cells.push_back(x * size + y);
+}
+
+// a cell shows the name of the one object in it, or a star if there are more
+void Map_view::fill_cell(int cell)
+{
+    const vector<const string*>& objects = cell_objects[cell];
+    char* cell_chars = &cells[2 * cell];
+    if (objects.empty()) {
+        cell_chars[0] = '.';
+        cell_chars[1] = ' ';
+    }
+    else if (objects.size() == 1) {
+        cell_chars[0] = (*objects.front())[0];
+        cell_chars[1] = (*objects.front())[1];
+    }
+    else {
+        cell_chars[0] = '*';
+        cell_chars[1] = ' ';
+    }
+}
+
+// The map is assembled in a character frame buffer that is kept between draws, so
+// once the buffers have grown to size, drawing does no allocation, and the frame is
+// written to the stream in one operation. Numbers are formatted as the stream would
+// with the fixed format set in main.
+void Map_view::draw_on(std::ostream& os)
+{
+    if (trails)
+        trail_paths = trails->get_paths();
+    frame.clear();
+    append_header(int(os.precision()));
+    fill_cells(true);
+    append_rows();
+    os.write(frame.data(), frame.size());
+    os.flush();
+}
+
+// the copy has the trails as they are now, and no recorder to share; it is never
+// drawn live, so it needs nothing that refers to this view's objects
+shared_ptr<View> Map_view::snapshot() const
+{
+    shared_ptr<Map_view> copy(new Map_view(*this));
+    copy->cell_objects.clear();
+    copy->live_frame_valid = false;
+    if (trails) {
+        copy->trail_paths = trails->get_paths();
+        copy->trails.reset();
+    }
+    return copy;
+}
+
+// The first live draw clears the screen, draws the map at the top of it without the
+// list of objects outside the map, and keeps it there by confining scrolling to the lines
+// below it. From then on, the objects in each cell are kept track of as they move, so
+// later draws work out only the cells they left or entered, and rewrite those that
+// changed, putting the cursor back where the other output left it.
+void Map_view::draw_live(std::ostream& os)
+{
+    if (trails)
+        trail_paths = trails->get_paths();
+    frame.clear();
+    if (!live_frame_valid) {
+        cell_objects.resize(size * size);
+        for (auto& objects : cell_objects)
+            objects.clear();
+        for (auto& map_pair : points)
+            enter_cell(map_pair.first, map_pair.second);
+        dirty_cells.clear();
+        trail_cells.clear();
+        fill_cells(false);
+        frame += "\x1b[r\x1b[2J\x1b[H";
+        append_header(int(os.precision()));
+        append_rows();
+        // scroll only the lines below the map, and leave the cursor there
+        frame += "\x1b[";
+        append_number(size + 3);
+        frame += ";r\x1b[";
+        append_number(size + 3);
+        frame += ";1H";
+        live_frame_valid = true;
+        live_screen_set = true;
+        previous_cells = cells;
+    }
+    else {
+        for (int cell : dirty_cells)
+            fill_cell(cell);
+        if (!trail_paths.empty() || !trail_cells.empty())
+            fill_trail_cells();
+        bool cursor_saved = false;
+        for (int cell : dirty_cells) {
+            if (cells[2 * cell] == previous_cells[2 * cell] &&
+                cells[2 * cell + 1] == previous_cells[2 * cell + 1])
+                continue;
+            if (!cursor_saved)
+                frame += "\x1b" "7";
+            cursor_saved = true;
+            // the header is on the first line, and the top row of the map on the second
+            int x = cell / size, y = cell % size;
+            frame += "\x1b[";
+            append_number(size - y + 1);
+            frame += ';';
+            append_number(label_width_c + 2 + 2 * x);
+            frame += 'H';
+            frame.append(&cells[2 * cell], 2);
+            previous_cells[2 * cell] = cells[2 * cell];
+            previous_cells[2 * cell + 1] = cells[2 * cell + 1];
+        }
+        if (cursor_saved)
+            frame += "\x1b" "8";
+    }
+    dirty_cells.clear();
+    os.write(frame.data(), frame.size());
+    os.flush();
+}
+
+void Map_view::set_live(bool live_)
+{
+    live = live_;
+    live_frame_valid = false;
+    dirty_cells.clear();
+}
+
+void Map_view::end_live_screen(std::ostream& os)
+{
+    if (live_screen_set)
+        os << "\x1b[r" << std::flush;
+    live_screen_set = false;
+}
+
+// The image is divided into bands of rows, one per thread. Each object's pixel is
+// computed once and put in the bucket of each band its dot reaches, so each thread
+// draws only the dots in its own band. Objects whose dots would be entirely outside the
+// image are left out before their pixel is converted to an int.
+void Map_view::export_image(const std::string& filename, int pixels, bool fit)
+{
+    if (pixels < 1 || pixels > max_image_pixels_c)
+        throw Error("Image size must be between 1 and 16384!");
+    Point image_origin = origin;
+    double extent = size * scale;
+    if (fit) {
+        if (!bounds_valid)
+            compute_bounds();
+        double width = bounds_max.x - bounds_min.x;
+        double height = bounds_max.y - bounds_min.y;
+        extent = std::max(std::max(width, height) * (1. + 2. * fit_margin_c), min_fit_extent_c);
+        image_origin = Point((bounds_min.x + bounds_max.x - extent) / 2.,
+                             (bounds_min.y + bounds_max.y - extent) / 2.);
+    }
+    int dot_radius = (pixels >= 100) ? 1 : 0;
+    int n_threads = std::max(1, std::min(int(std::thread::hardware_concurrency()),
+                                         pixels / min_band_rows_c));
+    int band_rows = (pixels + n_threads - 1) / n_threads;
+    int n_bands = (pixels + band_rows - 1) / band_rows;
+    // pixel rows go from the top down
+    vector<vector<std::pair<int, int> > > band_locations(n_bands);
+    for (auto& map_pair : points) {
+        Cartesian_vector offset = (map_pair.second - image_origin) / extent * pixels;
+        double row = pixels - 1 - floor(offset.delta_y), column = floor(offset.delta_x);
+        if (!(row >= -dot_radius && row < pixels + dot_radius &&
+              column >= -dot_radius && column < pixels + dot_radius))
+            continue;
+        std::pair<int, int> location = std::make_pair(int(row), int(column));
+        int first_band = std::max(location.first - dot_radius, 0) / band_rows;
+        int last_band = std::min(location.first + dot_radius, pixels - 1) / band_rows;
+        for (int band = first_band; band <= last_band; band++)
+            band_locations[band].push_back(location);
+    }
+    vector<unsigned char> image(size_t(pixels) * pixels, 255);
+    auto draw_band = [&](int band) {
+        int first_row = band * band_rows, last_row = std::min(first_row + band_rows, pixels);
+        for (auto& location : band_locations[band]) {
+            for (int row = std::max(location.first - dot_radius, first_row);
+                 row <= std::min(location.first + dot_radius, last_row - 1); row++) {
+                for (int column = std::max(location.second - dot_radius, 0);
+                     column <= std::min(location.second + dot_radius, pixels - 1); column++)
+                    image[size_t(row) * pixels + column] = 0;
+            }
         }
-    private:
-        ios::fmtflags old_flags;
-        streamsize old_precision;
     };
-    
-    cout << "Display size: " <<size << ", scale: " << scale << ", origin: " << origin << endl;
-    vector< vector<string> > output(size, vector<string>(size, ". "));
+    vector<std::thread> threads;
+    for (int band = 0; band < n_bands; band++)
+        threads.push_back(std::thread(draw_band, band));
+    for (auto& worker : threads)
+        worker.join();
+
+    std::ofstream image_file(filename, std::ios::binary);
+    image_file << "P5\n" << pixels << ' ' << pixels << "\n255\n";
+    image_file.write(reinterpret_cast<const char*>(image.data()), image.size());
+    if (!image_file)
+        throw Error("Could not write image file!");
+}
+
+void Map_view::append_header(int precision)
+{
+    frame += "Display size: ";
+    append_number(size);
+    frame += ", scale: ";
+    append_fixed(frame, scale, precision);
+    frame += ", origin: (";
+    append_fixed(frame, origin.x, precision);
+    frame += ", ";
+    append_fixed(frame, origin.y, precision);
+    frame += ")\n";
+}
+
+// each cell is two characters, column by column from the left, each column from the bottom
+void Map_view::fill_cells(bool list_outside)
+{
+    cells.assign(2 * size * size, ' ');
+    for (int i = 0; i < size * size; i++)
+        cells[2 * i] = '.';
     bool exist_out_of_map = false;
     for (auto& map_pair : points) {
         int x, y;
         if (get_subscripts(x, y, map_pair.second)) {
-            if (output[x][y] == ". ")
-                output[x][y] = map_pair.first.substr(0, 2);
-            else
-                output[x][y] = "* ";
-        }
-        else {
-            if (exist_out_of_map)
-                cout << ", " << map_pair.first;
+            char* cell = &cells[2 * (x * size + y)];
+            if (cell[0] == '.' && cell[1] == ' ') {
+                cell[0] = map_pair.first[0];
+                cell[1] = map_pair.first[1];
+            }
             else {
-                cout << map_pair.first;
-                exist_out_of_map = true;
+                cell[0] = '*';
+                cell[1] = ' ';
             }
         }
+        else if (list_outside) {
+            if (exist_out_of_map)
+                frame += ", ";
+            exist_out_of_map = true;
+            frame += map_pair.first;
+        }
     }
     if (exist_out_of_map)
-        cout << " outside the map" << endl;
-    Cout_format_saver cfs;
-    cout.precision(0);
+        frame += " outside the map\n";
+    fill_trail_cells();
+}
+
+// Each segment of a trail is clipped to the grid, then stepped along a cell at a
+// time. Cells that had a trail on the screen may need to be redrawn without it;
+// when drawing live, the cells are not filled afresh, so the old trail is removed.
+void Map_view::fill_trail_cells()
+{
+    if (live_frame_valid) {
+        for (int cell : trail_cells) {
+            if (cells[2 * cell] == ':')
+                cells[2 * cell] = '.';
+        }
+        dirty_cells.insert(dirty_cells.end(), trail_cells.begin(), trail_cells.end());
+    }
+    trail_cells.clear();
+    for (auto& path : trail_paths) {
+        for (size_t i = 1; i < path.size(); i++) {
+            Cartesian_vector start = (path[i - 1] - origin) / scale;
+            Cartesian_vector end = (path[i] - origin) / scale;
+            double t_enter = 0., t_leave = 1.;
+            double starts[2] = {start.delta_x, start.delta_y};
+            double changes[2] = {end.delta_x - start.delta_x, end.delta_y - start.delta_y};
+            for (int axis = 0; axis < 2 && t_enter <= t_leave; axis++) {
+                if (changes[axis] == 0.) {
+                    if (starts[axis] < 0. || starts[axis] > size)
+                        t_enter = 2.;
+                    continue;
+                }
+                double t_low = -starts[axis] / changes[axis];
+                double t_high = (size - starts[axis]) / changes[axis];
+                if (t_low > t_high)
+                    std::swap(t_low, t_high);
+                t_enter = std::max(t_enter, t_low);
+                t_leave = std::min(t_leave, t_high);
+            }
+            if (t_enter > t_leave)
+                continue;
+            double span = (t_leave - t_enter) *
+                std::max(std::fabs(changes[0]), std::fabs(changes[1]));
+            int n_steps = int(std::ceil(span)) + 1;
+            for (int step = 0; step <= n_steps; step++) {
+                double t = t_enter + (t_leave - t_enter) * step / n_steps;
+                int x = int(floor(starts[0] + t * changes[0]));
+                int y = int(floor(starts[1] + t * changes[1]));
+                if (x < 0 || x >= size || y < 0 || y >= size)
+                    continue;
+                char* cell = &cells[2 * (x * size + y)];
+                if (cell[0] == '.' && cell[1] == ' ') {
+                    cell[0] = ':';
+                    trail_cells.push_back(x * size + y);
+                }
+            }
+        }
+    }
+    if (live_frame_valid)
+        dirty_cells.insert(dirty_cells.end(), trail_cells.begin(), trail_cells.end());
+}
+
+// the rows of cells from the top, with labels on the left, then the labels along the bottom
+void Map_view::append_rows()
+{
     for (int i = 0; i < size; i++) {
-        cout << setw(label_width_c);
         if ((size - i) % axes_label_gap_c == 1)
-            cout << origin.y + scale * (size - i - 1);
+            append_fixed(frame, origin.y + scale * (size - i - 1), 0, label_width_c);
         else
-            cout << "";
-        cout << ' ';
+            frame.append(label_width_c, ' ');
+        frame += ' ';
         for (int j = 0; j < size; j++)
-            cout << output[j][size - i - 1];
-        cout << endl;
+            frame.append(&cells[2 * (j * size + size - i - 1)], 2);
+        frame += '\n';
     }
     for (int i = 0; i <= (size-1)/axes_label_gap_c ; i++) {
-        cout << "  " << setw(label_width_c) << origin.x + axes_label_gap_c * scale * i;
+        frame += "  ";
+        append_fixed(frame, origin.x + axes_label_gap_c * scale * i, 0, label_width_c);
     }
-    cout << endl;
+    frame += '\n';
+}
+
+void Map_view::append_number(int n)
+{
+    char buffer[number_buffer_size_c];
+    frame.append(buffer, snprintf(buffer, sizeof(buffer), "%d", n));
 }
 
 void Map_view::clear()
 {
     points.clear();
+    live_frame_valid = false;
+    bounds_valid = true;
 }
 
 void Map_view::set_size(int size_)
@@ -100,6 +454,7 @@ void Map_view::set_size(int size_)
     if (size_ > 30)
         throw Error("New map size is too big!");
     size = size_;
+    live_frame_valid = false;
 }
 
 void Map_view::set_scale(double scale_)
@@ -107,11 +462,13 @@ void Map_view::set_scale(double scale_)
     if (scale_ <= 0.0)
         throw Error("New map scale must be positive!");
     scale = scale_;
+    live_frame_valid = false;
 }
 
 void Map_view::set_origin(Point origin_)
 {
     origin = origin_;
+    live_frame_valid = false;
 }
 
 void Map_view::set_defaults()
@@ -119,8 +476,37 @@ void Map_view::set_defaults()
     size = 25;
     scale = 2.0;
     origin = Point(-10, -10);
+    live_frame_valid = false;
+}
+
+
+void Map_view::save_settings(Checkpoint_writer& writer) const
+{
+    writer.put_int(size);
+    writer.put_double(scale);
+    writer.put_point(origin);
+    writer.put_bool(live);
+}
+
+void Map_view::load_settings(Checkpoint_reader& reader)
+{
+    set_size(reader.get_int());
+    set_scale(reader.get_double());
+    set_origin(reader.get_point());
+    set_live(reader.get_bool());
+}
+
+void Map_view::set_trails(shared_ptr<Trail_recorder> trails_)
+{
+    trails = trails_;
+    trail_paths.clear();
 }
 
+void Map_view::get_display_area(Point& lower_left, Point& upper_right) const
+{
+    lower_left = origin;
+    upper_right = Point(origin.x + size * scale, origin.y + size * scale);
+}
 
 /* *** Use this function to calculate the subscripts for the cell. */
 
@@ -151,44 +537,407 @@ bool Map_view::get_subscripts(int &ix, int &iy, Point location)
 }
 
 
+Density_view::Density_view() :
+    zoom_level(default_density_zoom_c), origin(-10, -10), outside_count(0)
+{
+    clear();
+}
+
+void Density_view::update_location(const std::string& name, Point location)
+{
+    int cell = get_cell(location);
+    auto object_it = object_cells.find(name);
+    if (object_it == object_cells.end())
+        object_it = object_cells.insert(std::make_pair(name, -1)).first;
+    else if (object_it->second == cell)
+        return;
+    else
+        change_count(object_it->second, -1);
+    change_count(cell, 1);
+    object_it->second = cell;
+}
+
+void Density_view::update_remove(const std::string& name)
+{
+    auto object_it = object_cells.find(name);
+    if (object_it == object_cells.end())
+        return;
+    change_count(object_it->second, -1);
+    object_cells.erase(object_it);
+}
+
+void Density_view::change_count(int cell, int delta)
+{
+    if (cell < 0) {
+        outside_count += delta;
+        return;
+    }
+    int column = cell % density_grid_size_c, row = cell / density_grid_size_c;
+    for (int level = 0; level < int(counts.size()); level++)
+        counts[level][(row >> level) * (density_grid_size_c >> level) + (column >> level)] += delta;
+}
+
+int Density_view::get_cell(Point location) const
+{
+    Cartesian_vector offset = (location - density_grid_origin_c) / density_cell_size_c;
+    int column = int(floor(offset.delta_x)), row = int(floor(offset.delta_y));
+    if (column < 0 || column >= density_grid_size_c || row < 0 || row >= density_grid_size_c)
+        return -1;
+    return row * density_grid_size_c + column;
+}
+
+// Each cell is shown with a character from the ramp, scaled so that the most
+// crowded cell shown gets the last one.
+void Density_view::draw_on(std::ostream& os)
+{
+    int side = density_grid_size_c >> zoom_level;
+    double cell_size = density_cell_size_c * (1 << zoom_level);
+    Cartesian_vector offset = (origin - density_grid_origin_c) / cell_size;
+    int first_column = int(floor(offset.delta_x)), first_row = int(floor(offset.delta_y));
+    const vector<int>& level_counts = counts[zoom_level];
+    auto count_at = [&](int row, int column) {
+        return (row < 0 || row >= side || column < 0 || column >= side) ?
+            0 : level_counts[row * side + column];
+    };
+    int max_count = 0;
+    for (int i = 0; i < density_display_size_c; i++)
+        for (int j = 0; j < density_display_size_c; j++)
+            max_count = std::max(max_count, count_at(first_row + i, first_column + j));
+    
+    os << "Density view, zoom level " << zoom_level << " (" << Fixed_value(cell_size)
+        << " nm per cell), origin " << origin << endl;
+    os << "Most crowded cell shown: " << max_count << ", outside the grid: "
+        << outside_count << endl;
+    const int ramp_top = int(sizeof(density_ramp_c)) - 2;
+    string row_text;
+    for (int i = density_display_size_c - 1; i >= 0; i--) {
+        row_text.clear();
+        for (int j = 0; j < density_display_size_c; j++) {
+            int count = count_at(first_row + i, first_column + j);
+            // any non-zero count gets at least the first visible character
+            int ramp_index = (count == 0) ? 0 : 1 + (ramp_top - 1) * (count - 1) / std::max(max_count - 1, 1);
+            row_text += density_ramp_c[ramp_index];
+            row_text += ' ';
+        }
+        os << setw(label_width_c) << "" << ' ' << row_text << endl;
+    }
+}
+
+shared_ptr<View> Density_view::snapshot() const
+{
+    return shared_ptr<View>(new Density_view(*this));
+}
+
+void Density_view::clear()
+{
+    counts.clear();
+    for (int level = 0; (density_grid_size_c >> level) > 0; level++)
+        counts.push_back(vector<int>((density_grid_size_c >> level) * (density_grid_size_c >> level)));
+    object_cells.clear();
+    outside_count = 0;
+}
+
+void Density_view::set_zoom_level(int level)
+{
+    if (level < 0 || level >= int(counts.size()))
+        throw Error("Invalid zoom level!");
+    zoom_level = level;
+}
+
+void Density_view::set_origin(Point origin_)
+{
+    origin = origin_;
+}
+
+void Density_view::save_settings(Checkpoint_writer& writer) const
+{
+    writer.put_int(zoom_level);
+    writer.put_point(origin);
+}
+
+void Density_view::load_settings(Checkpoint_reader& reader)
+{
+    set_zoom_level(reader.get_int());
+    set_origin(reader.get_point());
+}
+
+
+Sailing_view::Sailing_view() :
+    sort_key(SORT_BY_NAME), descending(false), filter(ALL_SHIPS),
+    page_size(0), page_number(1), ordered(false), is_snapshot(false), snapshot_n_ships(0)
+{}
+
 void Sailing_view::update_fuel(const std::string& name, double fuel)
 {
-    ships_info[name].fuel = fuel;
+    auto ship_it = find_ship(name);
+    bool reorder = ordered && sort_key == SORT_BY_FUEL;
+    if (reorder)
+        erase_order(*ship_it);
+    ship_it->second.fuel = fuel;
+    if (reorder)
+        insert_order(*ship_it);
 }
 
 
 void Sailing_view::update_course(const std::string& name, double course)
 {
-    ships_info[name].cs.course = course;
+    auto ship_it = find_ship(name);
+    bool reorder = ordered && sort_key == SORT_BY_COURSE;
+    if (reorder)
+        erase_order(*ship_it);
+    ship_it->second.cs.course = course;
+    if (reorder)
+        insert_order(*ship_it);
 }
 
 void Sailing_view::update_speed(const std::string& name, double speed)
 {
-    ships_info[name].cs.speed = speed;
+    auto ship_it = find_ship(name);
+    // starting or stopping moves the ship to the other filter's tree
+    bool reorder = ordered && (sort_key == SORT_BY_SPEED ||
+                               (ship_it->second.cs.speed != 0.) != (speed != 0.));
+    if (reorder)
+        erase_order(*ship_it);
+    ship_it->second.cs.speed = speed;
+    if (reorder)
+        insert_order(*ship_it);
+}
+
+void Sailing_view::update_type(const std::string& name, const std::string& type_name)
+{
+    auto ship_it = find_ship(name);
+    if (ship_it->second.type_name == type_name)
+        return;
+    if (ordered)
+        erase_order(*ship_it);
+    ship_it->second.type_name = type_name;
+    if (ordered)
+        insert_order(*ship_it);
 }
 
 void Sailing_view::update_remove(const std::string& name)
 {
-    ships_info.erase(name);
+    auto ship_it = ships_info.find(name);
+    if (ship_it == ships_info.end())
+        return;
+    if (ordered)
+        erase_order(*ship_it);
+    ships_info.erase(ship_it);
 }
 
-void Sailing_view::draw()
+void Sailing_view::draw_on(std::ostream& os)
 {
-    cout << "----- Sailing Data -----" << endl;
-    cout << setw(sailing_view_field_width_c) << "Ship" << setw(sailing_view_field_width_c)
+    os << "----- Sailing Data -----" << endl;
+    os << setw(sailing_view_field_width_c) << "Ship" << setw(sailing_view_field_width_c)
         << "Fuel" << setw(sailing_view_field_width_c) << "Course"
         << setw(sailing_view_field_width_c) << "Speed" << endl;
-    for (auto& map_pair : ships_info)
-        cout << setw(sailing_view_field_width_c) << map_pair.first
-            << setw(sailing_view_field_width_c)
-            << map_pair.second.fuel << setw(sailing_view_field_width_c)
-            << map_pair.second.cs.course << setw(sailing_view_field_width_c)
-            << map_pair.second.cs.speed << endl;
+    size_t n_ships = snapshot_n_ships;
+    if (is_snapshot) {
+        format_in_parallel(os, snapshot_rows.size(), [this](std::ostream& row_os, size_t i) {
+            draw_ship(row_os, snapshot_rows[i]);
+        });
+    }
+    else {
+        listed_ships.clear();
+        list_ships([this](const Ships_info_t::value_type& ship) {listed_ships.push_back(&ship);});
+        format_in_parallel(os, listed_ships.size(), [this](std::ostream& row_os, size_t i) {
+            draw_ship(row_os, *listed_ships[i]);
+        });
+        n_ships = get_listed_tree().size();
+    }
+    if (page_size) {
+        size_t n_pages = std::max<size_t>(1, (n_ships + page_size - 1) / page_size);
+        os << "Page " << page_number << " of " << n_pages << endl;
+    }
+}
+
+// Only the ships that will be listed are copied.
+shared_ptr<View> Sailing_view::snapshot() const
+{
+    shared_ptr<Sailing_view> copy(new Sailing_view);
+    copy->is_snapshot = true;
+    copy->page_size = page_size;
+    copy->page_number = page_number;
+    copy->snapshot_n_ships = ordered ? get_listed_tree().size() : ships_info.size();
+    list_ships([&copy](const Ships_info_t::value_type& ship) {copy->snapshot_rows.push_back(ship);});
+    return copy;
+}
+
+void Sailing_view::list_ships(std::function<void(const Ships_info_t::value_type&)> f) const
+{
+    if (!ordered) {
+        for (auto& map_pair : ships_info)
+            f(map_pair);
+        return;
+    }
+    const Order_tree_t& tree = get_listed_tree();
+    size_t n_ships = tree.size();
+    size_t first = page_size ? size_t(page_size) * (page_number - 1) : 0;
+    size_t last = page_size ? std::min(n_ships, first + page_size) : n_ships;
+    if (first >= last)
+        return;
+    // descending order counts back from the largest key
+    auto order_it = tree.find_by_order(descending ? n_ships - 1 - first : first);
+    for (size_t i = first; i < last; i++) {
+        f(*order_it->ship);
+        if (i + 1 == last)
+            break;
+        if (descending)
+            --order_it;
+        else
+            ++order_it;
+    }
 }
 
 void Sailing_view::clear()
 {
     ships_info.clear();
+    for (auto& tree : order_trees)
+        tree.clear();
+    type_order_trees.clear();
+}
+
+void Sailing_view::set_sort(Sort_key_e sort_key_, bool descending_)
+{
+    bool key_changed = sort_key_ != sort_key;
+    sort_key = sort_key_;
+    descending = descending_;
+    update_ordering(key_changed);
+}
+
+void Sailing_view::set_filter(Filter_e filter_)
+{
+    filter = filter_;
+    update_ordering(false);
+}
+
+void Sailing_view::set_type_filter(const std::string& type_filter_)
+{
+    type_filter = type_filter_;
+    update_ordering(false);
+}
+
+void Sailing_view::set_page(int page_size_, int page_number_)
+{
+    if (page_size_ < 0)
+        throw Error("Invalid page size!");
+    if (page_number_ < 1)
+        throw Error("Invalid page number!");
+    page_size = page_size_;
+    page_number = page_number_;
+    update_ordering(false);
+}
+
+void Sailing_view::save_settings(Checkpoint_writer& writer) const
+{
+    writer.put_unsigned(sort_key);
+    writer.put_bool(descending);
+    writer.put_unsigned(filter);
+    writer.put_string(type_filter);
+    writer.put_int(page_size);
+    writer.put_int(page_number);
+}
+
+void Sailing_view::load_settings(Checkpoint_reader& reader)
+{
+    Sort_key_e new_sort_key = Sort_key_e(reader.get_enum(SORT_BY_SPEED + 1));
+    set_sort(new_sort_key, reader.get_bool());
+    set_filter(Filter_e(reader.get_enum(STOPPED_SHIPS + 1)));
+    set_type_filter(reader.get_string());
+    int new_page_size = reader.get_int();
+    set_page(new_page_size, reader.get_int());
+}
+
+Sailing_view::Ships_info_t::iterator Sailing_view::find_ship(const std::string& name)
+{
+    auto insert_result = ships_info.insert(Ships_info_t::value_type(name, Fuel_course_speed()));
+    if (insert_result.second && ordered)
+        insert_order(*insert_result.first);
+    return insert_result.first;
+}
+
+void Sailing_view::update_ordering(bool key_changed)
+{
+    bool should_order = sort_key != SORT_BY_NAME || descending || filter != ALL_SHIPS ||
+        !type_filter.empty() || page_size != 0;
+    if (should_order == ordered && !(ordered && key_changed))
+        return;
+    for (auto& tree : order_trees)
+        tree.clear();
+    type_order_trees.clear();
+    ordered = should_order;
+    if (ordered)
+        for (auto& map_pair : ships_info)
+            insert_order(map_pair);
+}
+
+void Sailing_view::insert_order(const Ships_info_t::value_type& ship)
+{
+    Order_key key = get_order_key(ship);
+    Filter_e state_filter = ship.second.cs.speed != 0. ? MOVING_SHIPS : STOPPED_SHIPS;
+    for (Order_trees_t* trees : {&order_trees, find_type_order_trees(ship)}) {
+        if (!trees)
+            continue;
+        (*trees)[ALL_SHIPS].insert(key);
+        (*trees)[state_filter].insert(key);
+    }
+}
+
+void Sailing_view::erase_order(const Ships_info_t::value_type& ship)
+{
+    Order_key key = get_order_key(ship);
+    Filter_e state_filter = ship.second.cs.speed != 0. ? MOVING_SHIPS : STOPPED_SHIPS;
+    for (Order_trees_t* trees : {&order_trees, find_type_order_trees(ship)}) {
+        if (!trees)
+            continue;
+        (*trees)[ALL_SHIPS].erase(key);
+        (*trees)[state_filter].erase(key);
+    }
+}
+
+Sailing_view::Order_trees_t* Sailing_view::find_type_order_trees(const Ships_info_t::value_type& ship)
+{
+    if (ship.second.type_name.empty())
+        return nullptr;
+    return &type_order_trees[ship.second.type_name];
+}
+
+// A type that no ship has had lists no ships.
+const Sailing_view::Order_tree_t& Sailing_view::get_listed_tree() const
+{
+    static const Order_tree_t no_ships;
+    if (type_filter.empty())
+        return order_trees[filter];
+    auto trees_it = type_order_trees.find(type_filter);
+    return trees_it == type_order_trees.end() ? no_ships : trees_it->second[filter];
+}
+
+Sailing_view::Order_key Sailing_view::get_order_key(const Ships_info_t::value_type& ship) const
+{
+    Order_key key = {0., &ship};
+    switch (sort_key) {
+        case SORT_BY_FUEL:
+            key.value = ship.second.fuel;
+            break;
+        case SORT_BY_COURSE:
+            key.value = ship.second.cs.course;
+            break;
+        case SORT_BY_SPEED:
+            key.value = ship.second.cs.speed;
+            break;
+        default:
+            break;
+    }
+    return key;
+}
+
+void Sailing_view::draw_ship(std::ostream& os, const Ships_info_t::value_type& ship) const
+{
+    os << setw(sailing_view_field_width_c) << ship.first
+        << setw(sailing_view_field_width_c)
+        << Fixed_value(ship.second.fuel) << setw(sailing_view_field_width_c)
+        << Fixed_value(ship.second.cs.course) << setw(sailing_view_field_width_c)
+        << Fixed_value(ship.second.cs.speed) << endl;
 }
 
 
@@ -200,58 +949,79 @@ void Bridge_view::update_course(const std::string& name, double course)
 
 void Bridge_view::update_location(const std::string& name, Point location)
 {
-    points[name] = location;
+    if (ownship_name == name)
+        ownship_location = location;
 }
 
 void Bridge_view::update_remove(const std::string& name)
 {
     if (name == ownship_name)
         sunk = true;
-    else
-        points.erase(name);
 }
 
-void Bridge_view::draw()
+void Bridge_view::draw_on(std::ostream& os)
 {
-    vector< vector<string> > output;
-    Point own_location = points[ownship_name];
-    if (sunk) {
-        cout << "Bridge view from " << ownship_name << " sunk at " <<
-            own_location << endl;
-        output = vector< vector<string> >(3, vector<string>(19, "w-"));
-    }
-    else {
-        cout << "Bridge view from " << ownship_name <<  " position "
-            << own_location << " heading " << ownship_course << endl;
-        output = vector< vector<string> >(3, vector<string>(19, ". "));
-        for (auto& map_pair : points) {
-            Compass_position relative_position(own_location, map_pair.second);
-            if (relative_position.range >= 0.005 && relative_position.range <= 20.) {
-                int x;
-                if (compute_subscribt(relative_position.bearing, x)) {
-                    if (output[2][x] == ". ")
-                        output[2][x] = map_pair.first.substr(0, 2);
-                    else
-                        output[2][x] = "**";
-                }
-            }
-        }
-    }
+    if (contact_index_ptr)
+        fill_output();
+    if (sunk)
+        os << "Bridge view from " << ownship_name << " sunk at " <<
+            ownship_location << endl;
+    else
+        os << "Bridge view from " << ownship_name <<  " position "
+            << ownship_location << " heading " << Fixed_value(ownship_course) << endl;
     for (int i = 0 ; i < axes_label_gap_c; i++) {
-        cout << setw(label_width_c) << "" << ' ';
+        os << setw(label_width_c) << "" << ' ';
         for (int j = 0; j < 19; j++)
-            cout << output[i][j];
-        cout << endl;
+            os << output[i][j];
+        os << endl;
     }
     for (int i = 0; i <= 6 ; i++) {
-        cout << "  " << setw(label_width_c) << -90 + axes_label_gap_c * 10 * i;
+        os << "  " << setw(label_width_c) << -90 + axes_label_gap_c * 10 * i;
+    }
+    os << endl;
+}
+
+// The contact index goes on changing, so the copy gets the finished output instead.
+shared_ptr<View> Bridge_view::snapshot() const
+{
+    shared_ptr<Bridge_view> copy(new Bridge_view(*this));
+    copy->fill_output();
+    copy->contact_index_ptr.reset();
+    copy->contacts.clear();
+    return copy;
+}
+
+void Bridge_view::fill_output()
+{
+    // the rows are reset in place, so that a draw reuses the strings of the last one
+    const char* background = sunk ? "w-" : ". ";
+    output.resize(3);
+    for (auto& row : output) {
+        row.resize(19);
+        for (auto& cell : row)
+            cell.assign(background, 2);
+    }
+    if (sunk)
+        return;
+    // the sector is a little wider than the view, so that contacts right at its
+    // edges are decided by compute_subscribt alone
+    contact_index_ptr->find(ownship_name, bridge_min_range_c, bridge_max_range_c,
+                            ownship_course - 90. - bridge_sector_margin_c,
+                            190. + 2. * bridge_sector_margin_c, contacts);
+    for (auto& contact : contacts) {
+        int x;
+        if (compute_subscribt(contact.bearing, x)) {
+            if (output[2][x] == ". ")
+                output[2][x].assign(*contact.name, 0, 2);
+            else
+                output[2][x] = "**";
+        }
     }
-    cout << endl;
 }
 
 void Bridge_view::clear()
 {
-    points.clear();
+    ownship_location = Point();
 }
 
 bool Bridge_view::compute_subscribt(double bearing, int &x)
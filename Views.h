@@ -2,10 +2,22 @@
 #define VIEWS_H
 
 #include "View.h"
+#include "Contact_index.h"
 #include "Navigation.h"
 #include "Geometry.h"
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <array>
+#include <cstddef>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+class Checkpoint_writer;
+class Checkpoint_reader;
+class Trail_recorder;
 
 class Map_view : public View {
 public:
@@ -17,7 +29,9 @@ public:
     void update_remove(const std::string& name) override;
     
 	// prints out the current map
-    void draw() override;
+    void draw_on(std::ostream& os) override;
+    
+    std::shared_ptr<View> snapshot() const override;
 	
 	// Discard the saved information - drawing will show only a empty pattern
     void clear() override;
@@ -35,12 +49,72 @@ public:
 	
 	// set the parameters to the default values
 	void set_defaults();
+	
+	// the corners of the area covered by the display
+	void get_display_area(Point& lower_left, Point& upper_right) const;
+	
+	// In live mode, the map is meant to be redrawn with draw_live after every update,
+	// on a terminal that understands ANSI cursor movement and scrolling regions. The map
+	// stays at the top of the screen while other output scrolls below it.
+	void set_live(bool live_);
+	bool is_live() const
+		{return live;}
+	// Redraw only the cells that changed since the last live draw; the first live draw
+	// after the mode or display parameters change clears the screen and draws the whole map.
+	void draw_live(std::ostream& os);
+	// give the whole screen back to scrolling output, if a live draw took the top of it
+	void end_live_screen(std::ostream& os);
+	
+	// Write a square PGM image of the map, pixels on a side, with each object drawn as
+	// a black dot. If fit is false, the image covers the area of the current display;
+	// otherwise it covers the bounding box of all objects.
+	// will throw Error("Image size must be between 1 and 16384!") or
+	// Error("Could not write image file!")
+	void export_image(const std::string& filename, int pixels, bool fit);
+	
+	// write the display parameters and mode to a checkpoint, and set them from one
+	// may throw the Errors thrown by the set functions
+	void save_settings(Checkpoint_writer& writer) const;
+	void load_settings(Checkpoint_reader& reader);
+	
+	// draw the trails kept by the recorder in the empty cells they pass through,
+	// or no trails if the pointer is empty
+	void set_trails(std::shared_ptr<Trail_recorder> trails_);
 
 private:
     int size;			// current size of the display
 	double scale;		// distance per cell of the display
 	Point origin;		// coordinates of the lower-left-hand corner
     std::map<std::string, Point> points;
+    std::string frame;		// the text of the map, reused on each draw
+    std::vector<char> cells;	// the map cells, reused on each draw
+    bool live;
+    bool live_frame_valid;		// previous_cells is what is on the screen, and cell_objects is current
+    bool live_screen_set;		// scrolling is confined to the lines below the map
+    std::vector<char> previous_cells;
+    std::vector<std::vector<const std::string*>> cell_objects;	// the names in each cell, while live
+    std::vector<int> dirty_cells;	// cells that may have changed since the last live draw
+    bool bounds_valid;			// bounds_min and bounds_max enclose all of the points exactly
+    Point bounds_min, bounds_max;
+    std::shared_ptr<Trail_recorder> trails;
+    std::vector<std::vector<Point>> trail_paths;	// as of the last draw, or the snapshot
+    std::vector<int> trail_cells;	// the cells the trails were drawn in
+    
+    // keep track of the object's name leaving or entering the cell containing the location
+    void enter_cell(const std::string& name, Point location);
+    void leave_cell(const std::string& name, Point location);
+    // set the cell's characters from the objects in it
+    void fill_cell(int cell);
+    // the bounds are no longer exact if an object leaves a location on them
+    void check_leaving_bounds(Point location);
+    void compute_bounds();
+    // the parts of the frame
+    void append_header(int precision);
+    void fill_cells(bool list_outside);
+    void fill_trail_cells();
+    void append_rows();
+    // append a number to the frame, formatted with printf's %d
+    void append_number(int n);
     
 	// Calculate the cell subscripts corresponding to the location parameter, using the
 	// current size, scale, and origin of the display.
@@ -50,39 +124,169 @@ private:
 
 
 
+/* A Density_view shows how many objects are in each cell of a square area, as a
+heatmap of characters, for use when there are too many objects to show by name.
+Counts are kept in a pyramid of grids: level 0 has the smallest cells, and each
+level above has cells twice as large on a side, covering the same area. Every
+level is kept up to date as objects move, so changing the zoom level or panning
+costs only the number of cells displayed, however many objects there are. */
+
+class Density_view : public View {
+public:
+    Density_view();
+    
+    void update_location(const std::string& name, Point location) override;
+    
+	// Remove the name and its location; no error if the name is not present.
+    void update_remove(const std::string& name) override;
+    
+	// prints out the heatmap
+    void draw_on(std::ostream& os) override;
+    
+    std::shared_ptr<View> snapshot() const override;
+	
+	// Discard the saved information - drawing will show only a empty pattern
+    void clear() override;
+    
+    // Show the level with cells 2^level nm on a side.
+    // will throw Error("Invalid zoom level!") if not between 0 and the top level
+    void set_zoom_level(int level);
+    
+    // set the lower-left-hand corner of the area shown; any values are legal
+    void set_origin(Point origin_);
+    
+    // write the zoom level and origin to a checkpoint, and set them from one
+    // may throw the Errors thrown by the set functions
+    void save_settings(Checkpoint_writer& writer) const;
+    void load_settings(Checkpoint_reader& reader);
+
+private:
+    int zoom_level;
+    Point origin;
+    // counts[level][row * side + column], side = grid_size >> level
+    std::vector<std::vector<int> > counts;
+    // the level 0 cell of each object, or -1 if it is outside the grid
+    std::map<std::string, int> object_cells;
+    int outside_count;
+    
+    // add delta to the count of the level 0 cell, and the cells containing it above
+    void change_count(int cell, int delta);
+    // level 0 cell containing the location, or -1 if it is outside the grid
+    int get_cell(Point location) const;
+};
+
+
 class Sailing_view : public View {
 public:
+    Sailing_view();
+    
     void update_fuel(const std::string& name, double fuel) override;
     
     void update_course(const std::string& name, double course) override;
     
     void update_speed(const std::string& name, double speed) override;
     
+    void update_type(const std::string& name, const std::string& type_name) override;
+    
     // Remove the ship; no error if the name is not present.
     void update_remove(const std::string& name) override;
     
 	// prints out the current map
-    void draw() override;
+    void draw_on(std::ostream& os) override;
+    
+    std::shared_ptr<View> snapshot() const override;
 	
 	// Discard the saved information - drawing will show only a empty pattern
     void clear() override;
     
+    // modify which ships are listed and in what order; by default all ships are
+    // listed in order of name
+    enum Sort_key_e {SORT_BY_NAME, SORT_BY_FUEL, SORT_BY_COURSE, SORT_BY_SPEED};
+    void set_sort(Sort_key_e sort_key_, bool descending_);
+    // a ship is moving if its speed is not zero
+    enum Filter_e {ALL_SHIPS, MOVING_SHIPS, STOPPED_SHIPS};
+    void set_filter(Filter_e filter_);
+    // list only the ships of the type, or of every type if it is empty
+    void set_type_filter(const std::string& type_filter_);
+    // list only the page of page_size ships with the number, starting with 1;
+    // a page_size of 0 lists all of the ships
+    // will throw Error("Invalid page size!") or Error("Invalid page number!")
+    void set_page(int page_size_, int page_number_);
+    
+    // write the sort, filters, and page to a checkpoint, and set them from one
+    // may throw the Errors thrown by the set functions
+    void save_settings(Checkpoint_writer& writer) const;
+    void load_settings(Checkpoint_reader& reader);
+    
 private:
     struct Fuel_course_speed
     {
         Course_speed cs;
         double fuel;
+        std::string type_name;	// empty until the ship's type is heard
         Fuel_course_speed(Course_speed cs_ = Course_speed(), double fuel_ = 0.) :
         cs(cs_), fuel(fuel_){}
     };
-    std::map<std::string, Fuel_course_speed> ships_info;
+    typedef std::map<std::string, Fuel_course_speed> Ships_info_t;
+    Ships_info_t ships_info;
+    
+    // When anything other than the default listing is chosen, the ships are also
+    // kept in order of the sort key, in one tree of all ships and one for each
+    // filter, both for every type and for each type of ship, so a ship is moved and a
+    // page is found in O(log N), and the page is listed in O(page_size).
+    struct Order_key {
+        double value;	// of the sort key; 0 when sorting by name
+        const Ships_info_t::value_type* ship;
+    };
+    struct Order_key_less {
+        bool operator() (const Order_key& k1, const Order_key& k2) const
+            {return k1.value < k2.value ||
+                (k1.value == k2.value && k1.ship->first < k2.ship->first);}
+    };
+    typedef __gnu_pbds::tree<Order_key, __gnu_pbds::null_type, Order_key_less,
+        __gnu_pbds::rb_tree_tag, __gnu_pbds::tree_order_statistics_node_update> Order_tree_t;
+    typedef std::array<Order_tree_t, 3> Order_trees_t;	// indexed by Filter_e
+    
+    Sort_key_e sort_key;
+    bool descending;
+    Filter_e filter;
+    std::string type_filter;	// empty for every type
+    int page_size;
+    int page_number;
+    bool ordered;	// the order trees are being kept
+    Order_trees_t order_trees;	// of every type
+    std::map<std::string, Order_trees_t> type_order_trees;
+    // a snapshot keeps copies of only the ships it lists, and how many there were to list
+    bool is_snapshot;
+    std::vector<Ships_info_t::value_type> snapshot_rows;
+    std::size_t snapshot_n_ships;
+    std::vector<const Ships_info_t::value_type*> listed_ships;	// reused by each draw
+    
+    // find the ship, adding it if it is new
+    Ships_info_t::iterator find_ship(const std::string& name);
+    // keep the trees if anything but the default listing is chosen, rebuilding
+    // them if they are kept and the key has changed
+    void update_ordering(bool key_changed);
+    void insert_order(const Ships_info_t::value_type& ship);
+    void erase_order(const Ships_info_t::value_type& ship);
+    // the trees of the ship's type, or nullptr if its type is not known yet
+    Order_trees_t* find_type_order_trees(const Ships_info_t::value_type& ship);
+    // the tree of the ships that are listed
+    const Order_tree_t& get_listed_tree() const;
+    Order_key get_order_key(const Ships_info_t::value_type& ship) const;
+    // call f with each ship that is listed, in order
+    void list_ships(std::function<void(const Ships_info_t::value_type&)> f) const;
+    // safe to call from several threads at once
+    void draw_ship(std::ostream& os, const Ships_info_t::value_type& ship) const;
 };
 
 
 class Bridge_view : public View {
 public:
-    Bridge_view(std::string ownship_name_) :
-        ownship_name(ownship_name_), sunk(false) {}
+    // contacts are found in the index, which must be attached to the Model
+    Bridge_view(std::string ownship_name_, std::shared_ptr<Contact_index> contact_index_ptr_) :
+        ownship_name(ownship_name_), ownship_course(0.), sunk(false),
+        contact_index_ptr(contact_index_ptr_) {}
 
     void update_course(const std::string& name, double course) override;
     
@@ -92,17 +296,25 @@ public:
     void update_remove(const std::string& name) override;
     
 	// prints out the current map
-    void draw() override;
+    void draw_on(std::ostream& os) override;
+    
+    std::shared_ptr<View> snapshot() const override;
 	
 	// Discard the saved information - drawing will show only a empty pattern
     void clear() override;
 
 private:
     std::string ownship_name;
+    Point ownship_location;
     double ownship_course;
     bool sunk;
-    std::map<std::string, Point> points;
+    std::shared_ptr<Contact_index> contact_index_ptr;
+    // reused by each draw
+    std::vector<Contact_index::Contact> contacts;
+    std::vector<std::vector<std::string> > output;
     
+    // find the contacts shown in the output rows, if afloat
+    void fill_output();
     bool compute_subscribt(double bearing, int &x);
 };
 
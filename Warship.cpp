@@ -1,9 +1,11 @@
 #include "Warship.h"
+#include "Log.h"
 #include "Utility.h"
+#include "Checkpoint.h"
 #include <iostream>
 
 using std::string;
-using std::cout; using std::endl;
+using std::endl;
 using std::shared_ptr;
 
 Warship::~Warship() {}
@@ -15,8 +17,8 @@ void Warship::update()
         shared_ptr<Ship> sp = get_target();
         if (!sp || !sp->is_afloat())
             stop_attack();
-        else
-            cout << get_name() << " is attacking " << endl;
+        else if (log_enabled(LOG_COMBAT))
+            get_output() << get_name() << " is attacking " << endl;
     }
 }
 
@@ -30,7 +32,8 @@ void Warship::attack(shared_ptr<Ship> target_ptr_)
         throw Error("Already attacking this target!");
     target_ptr = target_ptr_;
     attacking = true;
-    cout << get_name() << " will attack " << target_ptr_->get_name() << endl;
+    if (log_enabled(LOG_COMBAT))
+        get_output() << get_name() << " will attack " << target_ptr_->get_name() << endl;
 }
 
 void Warship::stop_attack()
@@ -39,20 +42,35 @@ void Warship::stop_attack()
         throw Error("Was not attacking!");
     attacking = false;
     target_ptr.reset();
-    cout << get_name() << " stopping attack" << endl;
+    if (log_enabled(LOG_COMBAT))
+        get_output() << get_name() << " stopping attack" << endl;
 }
 
 
 
-void Warship::describe() const
+void Warship::save_state(Checkpoint_writer& writer) const
+{
+    Ship::save_state(writer);
+    writer.put_bool(attacking);
+    writer.put_object(get_target().get());
+}
+
+void Warship::load_state(Checkpoint_reader& reader)
+{
+    Ship::load_state(reader);
+    attacking = reader.get_bool();
+    target_ptr = reader.get_ship_ptr();
+}
+
+void Warship::describe(std::ostream& os) const
 {
-    Ship::describe();
+    Ship::describe(os);
     if (attacking) {
         shared_ptr<Ship> sp = get_target();
         if (!sp)
-            cout << "Attacking absent ship" << endl;
+            os << "Attacking absent ship" << endl;
         else
-            cout << "Attacking " << sp->get_name() << endl;
+            os << "Attacking " << sp->get_name() << endl;
     }
 }
 
@@ -64,7 +82,8 @@ bool Warship::is_attacking() const
 
 void Warship::fire_at_target()
 {
-    cout << get_name() << " fires" << endl;
+    if (log_enabled(LOG_COMBAT))
+        get_output() << get_name() << " fires" << endl;
     get_target()->receive_hit(firepower, shared_from_this());
 }
 
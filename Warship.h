@@ -15,10 +15,10 @@ abstract base class, so concrete classes derived from Warship must be declared.
 class Warship : public Ship {
 public:
 	// initialize, then output constructor message
-	Warship(const std::string& name_, Point position_, double fuel_capacity_, 
+	Warship(Model& model_, const std::string& name_, Point position_, double fuel_capacity_, 
 		double maximum_speed_, double fuel_consumption_, int resistance_,
         int firepower_, double maximum_range_) :
-        Ship(name_, position_, fuel_capacity_, maximum_speed_, fuel_consumption_, resistance_),
+        Ship(model_, name_, position_, fuel_capacity_, maximum_speed_, fuel_consumption_, resistance_),
     firepower(firepower_), maximum_range(maximum_range_), attacking(false) {}
 
 	// a pure virtual function to mark this as an abstract class,
@@ -38,7 +38,10 @@ public:
 	// will throw Error("Was not attacking!") if not Attacking
 	void stop_attack() override;
 	
-	void describe() const override;
+	void describe(std::ostream& os) const override;
+	// the target is saved by name
+	void save_state(Checkpoint_writer& writer) const override;
+	void load_state(Checkpoint_reader& reader) override;
 
 protected:
 	// future projects may need additional protected members